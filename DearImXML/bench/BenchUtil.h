@@ -0,0 +1,67 @@
+#ifndef DEARIMXML_BENCHUTIL_H
+#define DEARIMXML_BENCHUTIL_H
+
+#include <ImGUI/imgui.h>
+#include <chrono>
+#include <cstdio>
+#include <fstream>
+#include <string>
+
+namespace ImXMLBench {
+
+	//ImGui context without a window or GPU backend, enough to run frames and build draw lists
+	inline void createHeadlessContext() {
+		ImGui::CreateContext();
+		ImGuiIO& io = ImGui::GetIO();
+		io.DisplaySize = ImVec2(1920, 1080);
+		io.IniFilename = nullptr;
+		unsigned char* pixels;
+		int width, height;
+		io.Fonts->GetTexDataAsRGBA32(&pixels, &width, &height);
+	}
+
+	//Writes a layout with the given number of windows, each with a block of common widgets
+	inline std::string writeLayout(const std::string& filename, int windows) {
+		std::ofstream file(filename);
+		file << "<?xml version=\"1.0\" encoding=\"UTF-8\"?>\n<group>\n";
+		for(int i = 0; i < windows; i++) {
+			file << "\t<begin name=\"Window " << i << "\">\n";
+			file << "\t\t<sameline>\n\t\t\t<text label=\"Row " << i << "\"/>\n\t\t\t<button id=\"btn" << i << "\" label=\"Press\"/>\n\t\t</sameline>\n";
+			file << "\t\t<sliderfloat label=\"value\" dynamic=\"float0\" min=\"0\" max=\"1\"/>\n";
+			file << "\t\t<checkbox label=\"enabled\" dynamic=\"bool0\"/>\n";
+			file << "\t\t<tree>\n\t\t\t<treenode label=\"details\">\n\t\t\t\t<text label=\"nested\"/>\n\t\t\t</treenode>\n\t\t</tree>\n";
+			for(int j = 0; j < 8; j++) {
+				file << "\t\t<text label=\"line " << j << "\"/>\n";
+			}
+			file << "\t</begin>\n";
+		}
+		file << "</group>\n";
+		return filename;
+	}
+
+	//Runs frames of fn and returns the mean time per frame in microseconds
+	template<typename Fn>
+	double runFrames(int frames, Fn fn) {
+		ImGuiIO& io = ImGui::GetIO();
+		auto start = std::chrono::steady_clock::now();
+		for(int i = 0; i < frames; i++) {
+			io.DeltaTime = 1.0f / 60.0f;
+			ImGui::NewFrame();
+			fn();
+			ImGui::Render();
+		}
+		std::chrono::duration<double, std::micro> elapsed = std::chrono::steady_clock::now() - start;
+		return elapsed.count() / frames;
+	}
+
+	//Runs frames of fn and prints the mean time per frame
+	template<typename Fn>
+	double timeFrames(const char* name, int frames, Fn fn) {
+		double perFrame = runFrames(frames, fn);
+		std::printf("%-32s %10.2f us/frame\n", name, perFrame);
+		return perFrame;
+	}
+
+}
+
+#endif /* DEARIMXML_BENCHUTIL_H */
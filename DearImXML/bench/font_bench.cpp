@@ -0,0 +1,65 @@
+#include <ImGUI/imgui.h>
+
+#include <XMLFonts.h>
+
+#include <chrono>
+#include <cstdio>
+#include <filesystem>
+#include <memory>
+#include <string>
+
+//Time to get a built font atlas from ImFontAtlas::Build and from an XMLFontCache hit. Without arguments
+//the atlas holds the ImGui default font at several sizes, a font file given on the command line is
+//added at the same sizes with Latin and Cyrillic glyphs.
+//Usage: DearImXMLFontBench [font.ttf]
+
+static const float sizes[] = {13.0f, 16.0f, 20.0f, 26.0f, 32.0f, 48.0f};
+
+static void addFonts(ImFontAtlas& atlas, const char* filename) {
+    for(float size : sizes) {
+        ImFontConfig config;
+        config.SizePixels = size;
+        config.OversampleH = 2;
+        config.PixelSnapH = false;
+        if(filename != nullptr) {
+            atlas.AddFontFromFileTTF(filename, size, &config, atlas.GetGlyphRangesCyrillic());
+        } else {
+            atlas.AddFontDefault(&config);
+        }
+    }
+}
+
+//Mean milliseconds to get a built atlas through build
+template<typename Fn>
+double timeBuilds(int runs, const char* filename, Fn build) {
+    double total = 0;
+    for(int i = 0; i < runs; i++) {
+        auto atlas = std::make_unique<ImFontAtlas>();
+        addFonts(*atlas, filename);
+        auto start = std::chrono::steady_clock::now();
+        build(*atlas);
+        total += std::chrono::duration<double, std::milli>(std::chrono::steady_clock::now() - start).count();
+    }
+    return total / runs;
+}
+
+int main(int argc, char** argv) {
+    const char* filename = argc > 1 ? argv[1] : nullptr;
+    std::string directory = "font_bench_cache";
+    std::filesystem::remove_all(directory);
+    ImXML::XMLFontCache cache(directory);
+    const int runs = 10;
+
+    double plain = timeBuilds(runs, filename, [](ImFontAtlas& atlas) { atlas.Build(); });
+    double miss = timeBuilds(1, filename, [&](ImFontAtlas& atlas) { cache.build(atlas); });
+    double hit = timeBuilds(runs, filename, [&](ImFontAtlas& atlas) { cache.build(atlas); });
+    ImXML::XMLCacheStats stats = cache.getStats();
+
+    std::printf("%s, %d sizes\n", filename != nullptr ? filename : "default font", (int)(sizeof(sizes) / sizeof(sizes[0])));
+    std::printf("%-24s %10.2f ms\n", "ImFontAtlas::Build", plain);
+    std::printf("%-24s %10.2f ms\n", "cache miss (build+store)", miss);
+    std::printf("%-24s %10.2f ms\n", "cache hit", hit);
+    std::printf("%u hits, %u misses\n", (unsigned int)stats.hits, (unsigned int)stats.misses);
+    std::filesystem::remove_all(directory);
+    return 0;
+}
@@ -0,0 +1,130 @@
+#include <ImGUI/imgui.h>
+#include <ImGUI/imgui_internal.h>
+
+#include <XMLReader.h>
+#include <XMLTree.h>
+#include <XMLRenderer.h>
+#include <XMLEventHandler.h>
+
+#include <BenchUtil.h>
+
+#include <algorithm>
+#include <chrono>
+
+//Compares the virtual XMLEventHandler against a statically dispatched handler on the same layout
+
+class VirtualHandler : public ImXML::XMLEventHandler {
+public:
+    int events = 0;
+
+    virtual void onNodeBegin(ImXML::XMLNode& node) override {
+
+    }
+
+    virtual void onNodeEnd(ImXML::XMLNode& node) override {
+
+    }
+
+    virtual void onEvent(ImXML::XMLNode& node) override {
+        events++;
+    }
+};
+
+class StaticHandler : public ImXML::XMLStaticEventHandler {
+public:
+    int events = 0;
+
+    void onEvent(ImXML::XMLNode& node) {
+        events++;
+    }
+};
+
+//The hook calls of one render without ImGui or the renderer, in the order traverse makes them
+template<typename Handler>
+void dispatch(ImXML::XMLNode& node, Handler& handler) {
+    handler.onNodeBegin(node);
+    handler.onEvent(node);
+    for(auto child : node.children) {
+        dispatch(*child, handler);
+    }
+    handler.onNodeEnd(node);
+}
+
+template<typename Fn>
+double timePasses(int passes, Fn fn) {
+    auto start = std::chrono::steady_clock::now();
+    for(int i = 0; i < passes; i++) {
+        fn();
+    }
+    std::chrono::duration<double, std::micro> elapsed = std::chrono::steady_clock::now() - start;
+    return elapsed.count() / passes;
+}
+
+int main(int argc, char const *argv[])
+{
+    int windows = argc > 1 ? std::stoi(argv[1]) : 200;
+    int frames = argc > 2 ? std::stoi(argv[2]) : 500;
+    ImXMLBench::createHeadlessContext();
+
+    ImXML::XMLReader reader;
+    ImXML::XMLTree tree = reader.read(ImXMLBench::writeLayout("handler_bench.xml", windows));
+    float float0 = 0.5f;
+    bool bool0 = true;
+
+    ImXML::XMLRenderer virtualRenderer;
+    virtualRenderer.addBind("float0", float0);
+    virtualRenderer.addBind("bool0", bool0);
+    VirtualHandler virtualHandler;
+
+    ImXML::BasicXMLRenderer<StaticHandler> staticRenderer;
+    staticRenderer.addBind("float0", float0);
+    staticRenderer.addBind("bool0", bool0);
+    StaticHandler staticHandler;
+
+    std::printf("%d windows, %d frames\n", windows, frames);
+    //Warm up window state so both runs see the same ImGui work
+    ImXMLBench::runFrames(10, [&]() { virtualRenderer.render(tree, virtualHandler); });
+    ImXMLBench::runFrames(10, [&]() { staticRenderer.render(tree, staticHandler); });
+
+    //Full frames, interleaved in short blocks that alternate which mode goes first so drift in
+    //clock speed or ImGui state hits both alike. ImGui itself dominates these numbers.
+    const int block = 10;
+    double virtualTime = 0;
+    double staticTime = 0;
+    for(int done = 0, round = 0; done < frames; done += block, round++) {
+        int count = std::min(block, frames - done);
+        auto runVirtual = [&]() { virtualTime += count * ImXMLBench::runFrames(count, [&]() { virtualRenderer.render(tree, virtualHandler); }); };
+        auto runStatic = [&]() { staticTime += count * ImXMLBench::runFrames(count, [&]() { staticRenderer.render(tree, staticHandler); }); };
+        if(round % 2 == 0) {
+            runVirtual();
+            runStatic();
+        } else {
+            runStatic();
+            runVirtual();
+        }
+    }
+    std::printf("%-32s %10.2f us/frame\n", "virtual XMLEventHandler", virtualTime / frames);
+    std::printf("%-32s %10.2f us/frame\n", "static XMLStaticEventHandler", staticTime / frames);
+    std::printf("static / virtual: %.3f\n", staticTime / virtualTime);
+
+    //Hook dispatch alone through a synthetic walk that calls the handler in the order traverse does, not
+    //through the renderer. The virtual handler is picked through a volatile index so the calls cannot be
+    //devirtualized.
+    VirtualHandler otherHandler;
+    ImXML::XMLEventHandler* handlers[] = {&virtualHandler, &otherHandler};
+    volatile int pick = 0;
+    ImXML::XMLEventHandler& opaque = *handlers[pick];
+    int passes = frames * 4;
+    double virtualDispatch = 0;
+    double staticDispatch = 0;
+    for(int round = 0; round < 8; round++) {
+        virtualDispatch += timePasses(passes / 8, [&]() { dispatch(tree.getRoot(), opaque); });
+        staticDispatch += timePasses(passes / 8, [&]() { dispatch(tree.getRoot(), staticHandler); });
+    }
+    std::printf("%-32s %10.2f us/pass\n", "virtual synthetic walk", virtualDispatch / 8);
+    std::printf("%-32s %10.2f us/pass\n", "static synthetic walk", staticDispatch / 8);
+    std::printf("static / virtual: %.3f (%d events)\n", staticDispatch / virtualDispatch, virtualHandler.events + staticHandler.events);
+
+    ImGui::DestroyContext();
+    return 0;
+}
@@ -0,0 +1,143 @@
+#include <ImGUI/imgui.h>
+#include <ImGUI/imgui_internal.h>
+
+#include <XMLReader.h>
+#include <XMLTree.h>
+#include <XMLRenderer.h>
+#include <XMLEventHandler.h>
+#include <XMLSession.h>
+
+#include <BenchUtil.h>
+#include <array>
+#include <deque>
+
+//Replays a recorded session (see main --record) against a layout at full speed.
+//Usage: DearImXMLReplayBench [layout.xml session.imxs]
+//Without arguments a scripted session is recorded on a generated layout first.
+
+class Handler : public ImXML::XMLStaticEventHandler {
+};
+
+using Renderer = ImXML::BasicXMLRenderer<Handler>;
+
+//Backing values for every dynamic attribute of a layout, typed after the widget using it
+class DummyBinds {
+    std::deque<float> floats;
+    std::deque<int> ints;
+    std::deque<bool> bools;
+    std::deque<double> doubles;
+    std::deque<std::array<float, 4>> colors;
+    std::deque<std::string> strings;
+
+public:
+    void bind(ImXML::XMLNode& node, Renderer& renderer) {
+        auto dynamic = node.args.find("dynamic");
+        if(dynamic != node.args.end()) {
+            std::string name = dynamic->second.str();
+            switch(node.type) {
+                case ImXML::ImGuiEnum::SLIDERFLOAT:
+                case ImXML::ImGuiEnum::INPUTFLOAT:
+                    renderer.addBind(name, floats.emplace_back(0.0f));
+                    break;
+                case ImXML::ImGuiEnum::SLIDERINT:
+                case ImXML::ImGuiEnum::INPUTINT:
+                case ImXML::ImGuiEnum::RADIOBUTTON:
+                    renderer.addBind(name, ints.emplace_back(0));
+                    break;
+                case ImXML::ImGuiEnum::CHECKBOX:
+                    renderer.addBind(name, bools.emplace_back(false));
+                    break;
+                case ImXML::ImGuiEnum::INPUTDOUBLE:
+                    renderer.addBind(name, doubles.emplace_back(0.0));
+                    break;
+                case ImXML::ImGuiEnum::INPUTTEXT:
+                    renderer.addBind(name, strings.emplace_back());
+                    break;
+                case ImXML::ImGuiEnum::COLORPICKER3:
+                case ImXML::ImGuiEnum::COLOREDIT3:
+                    renderer.addBind(name, reinterpret_cast<float(&)[3]>(*colors.emplace_back().data()));
+                    break;
+                case ImXML::ImGuiEnum::COLORPICKER4:
+                case ImXML::ImGuiEnum::COLOREDIT4:
+                    renderer.addBind(name, reinterpret_cast<float(&)[4]>(*colors.emplace_back().data()));
+                    break;
+                default:
+                    break;
+            }
+        }
+        for(auto child : node.children) {
+            bind(*child, renderer);
+        }
+    }
+};
+
+//Moves the mouse over the first windows and clicks, so the session contains button events
+static void recordScripted(ImXML::XMLTree& tree, Renderer& renderer, ImXML::XMLSession& session) {
+    ImXML::XMLRecorder recorder(session);
+    Handler handler;
+    renderer.setEventObserver(recorder.observer());
+    ImGuiIO& io = ImGui::GetIO();
+    for(int i = 0; i < 600; i++) {
+        io.DeltaTime = 1.0f / 60.0f;
+        float x = 20.0f + (i % 120) * 4.0f;
+        float y = 40.0f + (i / 120) * 30.0f;
+        io.AddMousePosEvent(x, y);
+        if(i % 10 == 5) {
+            io.AddMouseButtonEvent(0, true);
+        } else if(i % 10 == 6) {
+            io.AddMouseButtonEvent(0, false);
+        }
+        recorder.beginFrame();
+        ImGui::NewFrame();
+        renderer.render(tree, handler);
+        ImGui::Render();
+        recorder.endFrame();
+    }
+    renderer.setEventObserver(nullptr);
+}
+
+int main(int argc, char const *argv[])
+{
+    ImXMLBench::createHeadlessContext();
+    std::string layout = argc > 2 ? argv[1] : ImXMLBench::writeLayout("replay_bench.xml", 50);
+    std::string sessionFile = argc > 2 ? argv[2] : "replay_bench.imxs";
+
+    ImXML::XMLReader reader;
+    ImXML::XMLTree tree = reader.read(layout);
+    Renderer renderer;
+    DummyBinds binds;
+    binds.bind(tree.getRoot(), renderer);
+
+    if(argc <= 2) {
+        ImXML::XMLSession recorded;
+        recordScripted(tree, renderer, recorded);
+        recorded.save(sessionFile);
+        //Replay starts from a fresh context like a new run of the application would
+        ImGui::DestroyContext();
+        ImXMLBench::createHeadlessContext();
+    }
+
+    ImXML::XMLSession session;
+    session.load(sessionFile);
+    ImXML::XMLReplayer replayer(session);
+    renderer.setEventObserver(replayer.observer());
+    Handler handler;
+
+    std::size_t frames = session.getFrames().size();
+    std::size_t events = 0;
+    for(auto& frame : session.getFrames()) {
+        events += frame.events.size();
+    }
+    auto start = std::chrono::steady_clock::now();
+    while(replayer.beginFrame()) {
+        ImGui::NewFrame();
+        renderer.render(tree, handler);
+        ImGui::Render();
+        replayer.endFrame();
+    }
+    std::chrono::duration<double, std::micro> elapsed = std::chrono::steady_clock::now() - start;
+    std::printf("%zu frames and %zu events replayed, %.2f us/frame, %u frames with different events\n", frames, events, elapsed.count() / frames, replayer.getMismatches());
+
+    ImGui::DestroyContext();
+    return replayer.getMismatches() == 0 ? 0 : 1;
+}
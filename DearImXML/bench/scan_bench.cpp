@@ -0,0 +1,72 @@
+#include <XMLScan.h>
+#include <XMLCache.h>
+#include <XMLReader.h>
+
+#include <BenchUtil.h>
+#include <chrono>
+#include <cstdio>
+#include <string>
+#include <vector>
+
+//Throughput of the structural scanner on a generated multi-megabyte layout for every instruction set
+//the CPU supports, then the end-to-end parse time without the scan (one range) and with it (the
+//parallel parse, whose ranges are split on the index).
+//Usage: DearImXMLScanBench [layout.xml] [threads]
+
+static double seconds(std::chrono::steady_clock::time_point start) {
+    return std::chrono::duration<double>(std::chrono::steady_clock::now() - start).count();
+}
+
+int main(int argc, char** argv) {
+    std::string layout = argc > 1 ? argv[1] : ImXMLBench::writeLayout("scan_bench.xml", 16000);
+    ImXML::XMLMappedFile file(layout);
+    if(!file.isOpen()) {
+        std::printf("Cannot open %s\n", layout.c_str());
+        return 1;
+    }
+    std::string_view xml = file.view();
+    std::printf("%s: %.1f MB\n", layout.c_str(), xml.size() / (1024.0 * 1024.0));
+
+    const char* names[] = {"scalar", "sse2", "avx2"};
+    ImXML::XMLScanLevel best = ImXML::scanLevel();
+    std::vector<uint32_t> index;
+    for(int level = ImXML::XMLScan_Scalar; level <= best; level++) {
+        ImXML::scanLevel() = (ImXML::XMLScanLevel)level;
+        ImXML::buildStructuralIndex(xml, index);
+        const int runs = 20;
+        auto start = std::chrono::steady_clock::now();
+        for(int i = 0; i < runs; i++) {
+            ImXML::buildStructuralIndex(xml, index);
+        }
+        double elapsed = seconds(start) / runs;
+        std::printf("%-16s %8.2f ms %8.2f GB/s %10zu structural\n", names[level], elapsed * 1000.0, xml.size() / elapsed / 1e9, index.size());
+    }
+    ImXML::scanLevel() = best;
+
+    //Parses xml a few times and returns the best time in seconds
+    auto timeParse = [&](unsigned int threads, std::size_t& nodes) {
+        ImXML::XMLReader reader;
+        reader.setThreads(threads);
+        double fastest = 0;
+        for(int i = 0; i < 5; i++) {
+            auto start = std::chrono::steady_clock::now();
+            ImXML::XMLTree tree = reader.readBuffer(xml);
+            double elapsed = seconds(start);
+            fastest = i == 0 || elapsed < fastest ? elapsed : fastest;
+            nodes = tree.getCapacity();
+        }
+        return fastest;
+    };
+    unsigned int threads = argc > 2 ? std::stoi(argv[2]) : 4;
+    std::size_t nodes = 0;
+    double single = timeParse(1, nodes);
+    std::printf("%-16s %8.2f ms %8.2f GB/s %10zu nodes\n", "parse, no scan", single * 1000.0, xml.size() / single / 1e9, nodes);
+    for(int level = ImXML::XMLScan_Scalar; level <= best; level++) {
+        ImXML::scanLevel() = (ImXML::XMLScanLevel)level;
+        double parallel = timeParse(threads, nodes);
+        std::string name = std::string("parse, ") + names[level];
+        std::printf("%-16s %8.2f ms %8.2f GB/s %10zu nodes, %u threads\n", name.c_str(), parallel * 1000.0, xml.size() / parallel / 1e9, nodes, threads);
+    }
+    ImXML::scanLevel() = best;
+    return 0;
+}
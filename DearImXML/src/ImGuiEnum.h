@@ -1,11 +1,52 @@
 #ifndef IMGUIENUM_H
 #define IMGUIENUM_H
 
+#include <string>
+#include <unordered_map>
+
 namespace ImXML {
 	enum ImGuiEnum {
 		BEGIN, PLACEHOLDER, BUTTON, TEXT, SAMELINE, MENUBAR, MENU, MENUITEM, SLIDERFLOAT, INPUTTEXT, 
 		TREENODE, TREE, COLUMNS, COLUMN, GROUP, COLORPICKER3, COLORPICKER4, COLOREDIT3, COLOREDIT4,
-		POPUPCONTEXTWINDOW, SEPARATOR,
+		POPUPCONTEXTWINDOW, SEPARATOR, CHECKBOX, SLIDERINT, INPUTINT, INPUTFLOAT, INPUTDOUBLE, RADIOBUTTON,
+		TEMPLATE, USE, FONT, PUSHFONT,
+		IMGUIENUM_COUNT
+	};
+
+	//Lower case tag names as they appear in layouts
+	inline const std::unordered_map<std::string, ImGuiEnum> tagnames = {
+		{ "begin", ImGuiEnum::BEGIN },
+		{ "button" , ImGuiEnum::BUTTON },
+		{ "placeholder", ImGuiEnum::PLACEHOLDER },
+		{ "text", ImGuiEnum::TEXT },
+		{ "sameline", ImGuiEnum::SAMELINE },
+		{ "menubar", ImGuiEnum::MENUBAR },
+		{ "menu", ImGuiEnum::MENU },
+		{ "menuitem", ImGuiEnum::MENUITEM },
+		{ "sliderfloat", ImGuiEnum::SLIDERFLOAT },
+		{ "inputtext", ImGuiEnum::INPUTTEXT },
+		{ "treenode", ImGuiEnum::TREENODE },
+		{ "tree", ImGuiEnum::TREE },
+		{ "columns", ImGuiEnum::COLUMNS },
+		{ "column", ImGuiEnum::COLUMN },
+		{ "group", ImGuiEnum::GROUP },
+		{ "colorpicker3", ImGuiEnum::COLORPICKER3 },
+		{ "colorpicker4", ImGuiEnum::COLORPICKER4 },
+		{ "coloredit3", ImGuiEnum::COLOREDIT3 },
+		{ "coloredit4", ImGuiEnum::COLOREDIT4 },
+		{ "popupcontextwindow", ImGuiEnum::POPUPCONTEXTWINDOW },
+		{ "separator", ImGuiEnum::SEPARATOR },
+		{ "checkbox", ImGuiEnum::CHECKBOX },
+		{ "sliderint", ImGuiEnum::SLIDERINT },
+		{ "inputint", ImGuiEnum::INPUTINT },
+		{ "inputfloat", ImGuiEnum::INPUTFLOAT },
+		{ "inputdouble", ImGuiEnum::INPUTDOUBLE },
+		{ "radiobutton", ImGuiEnum::RADIOBUTTON },
+		{ "template", ImGuiEnum::TEMPLATE },
+		{ "use", ImGuiEnum::USE },
+		{ "font", ImGuiEnum::FONT },
+		{ "pushfont", ImGuiEnum::PUSHFONT },
+
 	};
 }
 
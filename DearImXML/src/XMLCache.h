@@ -0,0 +1,396 @@
+#ifndef DEARIMXML_XMLCACHE_H
+#define DEARIMXML_XMLCACHE_H
+
+#include <XMLTree.h>
+#include <ImGuiEnum.h>
+#include <ImGUI/imgui.h>
+#include <algorithm>
+#include <atomic>
+#include <chrono>
+#include <cstdint>
+#include <cstdio>
+#include <cstring>
+#include <filesystem>
+#include <fstream>
+#include <mutex>
+#include <random>
+#include <string>
+#include <string_view>
+#include <thread>
+#include <unordered_map>
+#include <vector>
+
+#if defined(__unix__) || defined(__APPLE__)
+#include <fcntl.h>
+#include <sys/mman.h>
+#include <sys/stat.h>
+#include <unistd.h>
+#elif defined(_WIN32)
+#include <process.h>
+#endif
+
+namespace ImXML {
+
+	//Hash of a whole document, reads 8 bytes per step so hashing stays cheap next to reading the file
+	inline uint64_t hashBytes(std::string_view data, uint64_t seed = 0) {
+		const uint64_t m = 0x9e3779b97f4a7c15ull;
+		uint64_t hash = seed ^ (data.size() * m);
+		const char* p = data.data();
+		std::size_t i = 0;
+		for(; i + 8 <= data.size(); i += 8) {
+			uint64_t v;
+			std::memcpy(&v, p + i, 8);
+			v *= m;
+			v ^= v >> 32;
+			hash = (hash ^ v) * m;
+			hash ^= hash >> 29;
+		}
+		uint64_t tail = 0;
+		if(i < data.size()) {
+			std::memcpy(&tail, p + i, data.size() - i);
+		}
+		hash = (hash ^ (tail * m)) * m;
+		hash ^= hash >> 32;
+		return hash;
+	}
+
+	//Name next to path for writing an entry before it is renamed over path. Unique across the threads and
+	//processes sharing a cache directory.
+	inline std::filesystem::path uniqueTempPath(const std::filesystem::path& path) {
+		static std::atomic<uint64_t> counter{std::random_device()()};
+#if defined(_WIN32)
+		int pid = _getpid();
+#elif defined(__unix__) || defined(__APPLE__)
+		int pid = getpid();
+#else
+		int pid = 0;
+#endif
+		std::filesystem::path temp = path;
+		temp += "." + std::to_string(pid) + "." + std::to_string(counter++) + ".tmp";
+		return temp;
+	}
+
+	//Writes a cache entry under a unique name and renames it over path so readers never see a partial
+	//entry. Returns false when either step fails, the temporary file is removed then.
+	inline bool writeEntry(const std::filesystem::path& path, std::string_view data) {
+		std::filesystem::path temp = uniqueTempPath(path);
+		std::error_code ec;
+		bool written;
+		{
+			std::ofstream file(temp, std::ios::binary);
+			file.write(data.data(), data.size());
+			file.close();
+			written = !file.fail();
+		}
+		if(written) {
+			std::filesystem::rename(temp, path, ec);
+		}
+		if(!written || ec) {
+			std::filesystem::remove(temp, ec);
+			return false;
+		}
+		return true;
+	}
+
+	//Read only view of a whole file, memory mapped where available. Files that may be truncated while
+	//they are read, e.g. ones being edited, are copied instead: a shrinking mapping faults on access.
+	class XMLMappedFile
+	{
+	private:
+		const char* data = nullptr;
+		std::size_t size = 0;
+		std::vector<char> buffer;	//fallback when the file cannot be mapped
+		bool mapped = false;
+		bool opened = false;
+	public:
+		XMLMappedFile(const std::string& filename, bool map = true);
+		~XMLMappedFile();
+
+		XMLMappedFile(const XMLMappedFile&) = delete;
+		XMLMappedFile& operator=(const XMLMappedFile&) = delete;
+
+		bool isOpen() const {
+			return opened;
+		}
+
+		std::string_view view() const {
+			return std::string_view(data, size);
+		}
+	};
+
+	XMLMappedFile::XMLMappedFile(const std::string& filename, bool map)
+	{
+#if defined(__unix__) || defined(__APPLE__)
+		int fd = map ? open(filename.c_str(), O_RDONLY) : -1;
+		if(fd >= 0) {
+			struct stat info;
+			if(fstat(fd, &info) == 0 && info.st_size > 0) {
+				void* view = mmap(nullptr, info.st_size, PROT_READ, MAP_PRIVATE, fd, 0);
+				if(view != MAP_FAILED) {
+					data = static_cast<const char*>(view);
+					size = info.st_size;
+					mapped = true;
+					opened = true;
+				}
+			}
+			close(fd);
+			if(mapped) {
+				return;
+			}
+		}
+#endif
+		std::ifstream file(filename, std::ios::binary);
+		if(file) {
+			buffer.assign(std::istreambuf_iterator<char>(file), std::istreambuf_iterator<char>());
+			data = buffer.data();
+			size = buffer.size();
+			opened = true;
+		}
+	}
+
+	XMLMappedFile::~XMLMappedFile()
+	{
+#if defined(__unix__) || defined(__APPLE__)
+		if(mapped) {
+			munmap(const_cast<char*>(data), size);
+		}
+#endif
+	}
+
+	struct XMLCacheStats
+	{
+		unsigned int hits = 0;
+		unsigned int misses = 0;
+		unsigned int evictions = 0;
+		std::size_t bytes = 0;	//size of the cache directory after the last store
+	};
+
+	//Directory of parsed layouts keyed by a hash of the XML bytes and of everything the parse result depends on.
+	//A hit rebuilds the tree from a memory mapped binary file without tokenizing. Least recently used entries
+	//are evicted once the directory grows past maxBytes. One cache can be shared by readers on several threads.
+	class XMLLayoutCache
+	{
+	private:
+		//Bump when the file layout or the parse result of the reader changes
+		static constexpr uint32_t formatVersion = 1;
+		static constexpr uint32_t magic = 0x43584d49; //"IMXC"
+		//Deepest nesting of a cached layout
+		static constexpr unsigned int maxDepth = 1024;
+
+		std::filesystem::path directory;
+		std::size_t maxBytes;
+		std::mutex mutex;
+		XMLCacheStats stats;
+
+		std::filesystem::path entryPath(uint64_t key) const {
+			char name[32];
+			std::snprintf(name, sizeof(name), "%016llx.imxc", (unsigned long long)key);
+			return directory / name;
+		}
+
+		template<typename T>
+		static void put(std::string& out, T value) {
+			out.append(reinterpret_cast<const char*>(&value), sizeof(T));
+		}
+
+		template<typename T>
+		static T get(std::string_view data, std::size_t& offset) {
+			if(offset + sizeof(T) > data.size()) {
+				throw std::runtime_error("Truncated layout cache entry");
+			}
+			T value;
+			std::memcpy(&value, data.data() + offset, sizeof(T));
+			offset += sizeof(T);
+			return value;
+		}
+
+		//Returns false when the layout is too deep to be read back
+		static bool writeNode(const XMLNode& node, std::unordered_map<std::string_view, uint32_t>& strings, std::vector<std::string_view>& order, std::string& out, unsigned int depth = 0) {
+			if(depth > maxDepth) {
+				return false;
+			}
+			auto ordinal = [&](std::string_view str) {
+				auto found = strings.emplace(str, (uint32_t)order.size());
+				if(found.second) {
+					order.push_back(str);
+				}
+				return found.first->second;
+			};
+			put<uint16_t>(out, node.type);
+			put<int32_t>(out, node.flags);
+			put<uint32_t>(out, node.children.size());
+			put<uint16_t>(out, node.args.size());
+			for(const XMLAttribute& arg : node.args) {
+				put<uint32_t>(out, ordinal(arg.first));
+				put<uint32_t>(out, ordinal(arg.second));
+			}
+			for(auto child : node.children) {
+				if(!writeNode(*child, strings, order, out, depth + 1)) {
+					return false;
+				}
+			}
+			return true;
+		}
+
+		//Entries are untrusted, the depth is capped so a damaged one cannot exhaust the stack here or in the
+		//recursive walks over the loaded tree. Deeper layouts are parsed every time.
+		static void readNode(std::string_view data, std::size_t& offset, const std::vector<XMLString>& strings, XMLTree& tree, XMLNode* parent, unsigned int depth = 0) {
+			if(depth > maxDepth) {
+				throw std::runtime_error("Layout cache entry too deep");
+			}
+			uint16_t type = get<uint16_t>(data, offset);
+			if(type >= IMGUIENUM_COUNT) {
+				throw std::runtime_error("Invalid tag in layout cache entry");
+			}
+			XMLNode& node = tree.createNode((ImGuiEnum)type, parent);
+			if(parent == nullptr) {
+				tree.setRoot(node);
+			}
+			node.flags = get<int32_t>(data, offset);
+			uint32_t children = get<uint32_t>(data, offset);
+			uint16_t args = get<uint16_t>(data, offset);
+			for(uint16_t i = 0; i < args; i++) {
+				uint32_t name = get<uint32_t>(data, offset);
+				uint32_t value = get<uint32_t>(data, offset);
+				if(name >= strings.size() || value >= strings.size()) {
+					throw std::runtime_error("Invalid string in layout cache entry");
+				}
+				node.args.emplace(strings[name], strings[value]);
+			}
+			for(uint32_t i = 0; i < children; i++) {
+				readNode(data, offset, strings, tree, &node, depth + 1);
+			}
+		}
+
+		//Removes the oldest entries until the directory fits, mutex must be held
+		void evict() {
+			std::vector<std::pair<std::filesystem::file_time_type, std::filesystem::path>> entries;
+			std::size_t total = 0;
+			std::error_code ec;
+			for(const auto& entry : std::filesystem::directory_iterator(directory, ec)) {
+				if(entry.path().extension() == ".imxc") {
+					total += entry.file_size(ec);
+					entries.push_back({entry.last_write_time(ec), entry.path()});
+				}
+			}
+			std::sort(entries.begin(), entries.end());
+			//Keeps the newest entry even when it alone is over the cap
+			for(std::size_t i = 0; total > maxBytes && i + 1 < entries.size(); i++) {
+				std::size_t size = std::filesystem::file_size(entries[i].second, ec);
+				if(std::filesystem::remove(entries[i].second, ec)) {
+					total -= size;
+					stats.evictions++;
+				}
+			}
+			stats.bytes = total;
+		}
+	public:
+		XMLLayoutCache(const std::string& directory, std::size_t maxBytes = 64 * 1024 * 1024);
+		~XMLLayoutCache();
+
+		//Key of a document, includes the versions the parse result depends on
+		static uint64_t key(std::string_view xml) {
+			return hashBytes(xml, ((uint64_t)formatVersion << 48) ^ ((uint64_t)IMGUI_VERSION_NUM << 16) ^ IMGUIENUM_COUNT);
+		}
+
+		//Builds the cached tree for key into tree, interning its strings into the tree pool. Returns false on a miss.
+		bool load(uint64_t key, XMLTree& tree) {
+			std::filesystem::path path = entryPath(key);
+			XMLMappedFile file(path.string());
+			bool hit = false;
+			if(file.isOpen()) {
+				try {
+					std::string_view data = file.view();
+					std::size_t offset = 0;
+					if(get<uint32_t>(data, offset) == magic && get<uint32_t>(data, offset) == formatVersion && get<uint64_t>(data, offset) == key) {
+						uint32_t count = get<uint32_t>(data, offset);
+						if(count > data.size()) {
+							throw std::runtime_error("Invalid layout cache entry");
+						}
+						std::vector<XMLString> strings(count);
+						XMLTree loaded(tree.getStrings());
+						XMLStringPool& pool = *loaded.getStrings();
+						for(XMLString& str : strings) {
+							uint32_t length = get<uint32_t>(data, offset);
+							if(offset + length > data.size()) {
+								throw std::runtime_error("Truncated layout cache entry");
+							}
+							str = pool.intern(data.substr(offset, length));
+							offset += length;
+						}
+						readNode(data, offset, strings, loaded, nullptr);
+						loaded.reindex();
+						tree = std::move(loaded);
+						hit = true;
+					}
+				} catch(const std::runtime_error&) {
+					//Damaged entries are treated as a miss and overwritten by the next store
+				}
+			}
+			std::lock_guard<std::mutex> lock(mutex);
+			if(hit) {
+				stats.hits++;
+				//The modification time orders entries for eviction
+				std::error_code ec;
+				std::filesystem::last_write_time(path, std::filesystem::file_time_type::clock::now(), ec);
+			} else {
+				stats.misses++;
+			}
+			return hit;
+		}
+
+		void store(uint64_t key, const XMLTree& tree) {
+			std::string nodes;
+			std::unordered_map<std::string_view, uint32_t> strings;
+			std::vector<std::string_view> order;
+			if(!writeNode(tree.getRoot(), strings, order, nodes)) {
+				return;
+			}
+			std::string out;
+			put<uint32_t>(out, magic);
+			put<uint32_t>(out, formatVersion);
+			put<uint64_t>(out, key);
+			put<uint32_t>(out, order.size());
+			for(std::string_view str : order) {
+				put<uint32_t>(out, str.size());
+				out.append(str);
+			}
+			out += nodes;
+
+			std::error_code ec;
+			std::filesystem::create_directories(directory, ec);
+			if(!writeEntry(entryPath(key), out)) {
+				return;
+			}
+			std::lock_guard<std::mutex> lock(mutex);
+			evict();
+		}
+
+		XMLCacheStats getStats() {
+			std::lock_guard<std::mutex> lock(mutex);
+			return stats;
+		}
+
+		void clear() {
+			std::lock_guard<std::mutex> lock(mutex);
+			std::error_code ec;
+			for(const auto& entry : std::filesystem::directory_iterator(directory, ec)) {
+				if(entry.path().extension() == ".imxc") {
+					std::filesystem::remove(entry.path(), ec);
+				}
+			}
+			stats.bytes = 0;
+		}
+	};
+
+	XMLLayoutCache::XMLLayoutCache(const std::string& directory, std::size_t maxBytes) : directory(directory), maxBytes(maxBytes)
+	{
+	}
+
+	XMLLayoutCache::~XMLLayoutCache()
+	{
+	}
+
+}
+
+#endif /* DEARIMXML_XMLCACHE_H */
@@ -1,10 +1,27 @@
 #ifndef DEARIMXML_XMLDYNAMICBIND_H
 #define DEARIMXML_XMLDYNAMICBIND_H
 
+#include <cstddef>
+#include <functional>
+#include <stdexcept>
+#include <string>
+#include <type_traits>
+#include <unordered_map>
+#include <vector>
+
 namespace ImXML {
 
 	enum XMLDynamicBindType {
-		Float, Int, Chars,
+		Float, Int, Chars, Bool, Double, Float3, Float4, String, Enum,
+	};
+
+	struct XMLBindCallbacks
+	{
+		std::function<void()> onChange;
+		std::function<void(const void* oldValue, const void* newValue)> onEvent;
+		//Value type onEvent was registered for, checked against the bind when the tree is linked
+		XMLDynamicBindType eventType = Float;
+		unsigned int eventSize = 0;
 	};
 
 	struct XMLDynamicBind
@@ -12,9 +29,118 @@ namespace ImXML {
 		void* ptr;
 		unsigned int size;
 		XMLDynamicBindType type;
+		//Only set for Enum binds, converts from and to the underlying value without knowing the enum type
+		int (*getEnum)(const void* ptr) = nullptr;
+		void (*setEnum)(void* ptr, int value) = nullptr;
+		//Set when the tree is linked if callbacks were registered for this bind
+		XMLBindCallbacks* callbacks = nullptr;
+	};
+
+	template<typename T, typename Enable = void>
+	struct XMLBindTraits;
+
+	template<> struct XMLBindTraits<float> { static constexpr XMLDynamicBindType type = Float; };
+	template<> struct XMLBindTraits<int> { static constexpr XMLDynamicBindType type = Int; };
+	template<> struct XMLBindTraits<bool> { static constexpr XMLDynamicBindType type = Bool; };
+	template<> struct XMLBindTraits<double> { static constexpr XMLDynamicBindType type = Double; };
+	template<> struct XMLBindTraits<float[3]> { static constexpr XMLDynamicBindType type = Float3; };
+	template<> struct XMLBindTraits<float[4]> { static constexpr XMLDynamicBindType type = Float4; };
+	template<> struct XMLBindTraits<std::string> { static constexpr XMLDynamicBindType type = String; };
+	template<std::size_t N> struct XMLBindTraits<char[N]> { static constexpr XMLDynamicBindType type = Chars; };
+	template<typename T> struct XMLBindTraits<T, std::enable_if_t<std::is_enum_v<T>>> { static constexpr XMLDynamicBindType type = Enum; };
+
+	template<typename T>
+	XMLDynamicBind makeBind(T& value) {
+		XMLDynamicBind bind = {.ptr = &value, .size = sizeof(T), .type = XMLBindTraits<T>::type};
+		if constexpr (std::is_enum_v<T>) {
+			bind.getEnum = [](const void* ptr) { return static_cast<int>(*static_cast<const T*>(ptr)); };
+			bind.setEnum = [](void* ptr, int value) { *static_cast<T*>(ptr) = static_cast<T>(value); };
+		}
+		return bind;
+	}
+
+	//Name of a bind type, used in link errors
+	inline const char* bindTypeName(XMLDynamicBindType type) {
+		switch(type) {
+			case Float: return "float";
+			case Int: return "int";
+			case Chars: return "char[]";
+			case Bool: return "bool";
+			case Double: return "double";
+			case Float3: return "float[3]";
+			case Float4: return "float[4]";
+			case String: return "std::string";
+			case Enum: return "enum";
+		}
+		return "unknown";
+	}
+
+	//Value pointers for one render of a linked tree, one per bind slot, see BasicXMLRenderer::render
+	struct XMLBindScope
+	{
+		std::vector<void*> ptrs;
+		unsigned int slotGeneration = 0;	//of the tree when the layout was made
 	};
-	
-	
+
+	//Bind slots of a linked tree by bind name, built once with BasicXMLRenderer::bindLayout and
+	//used to fill the scopes the tree is rendered against. The binds are copied, the renderer may
+	//reallocate its own when binds are added.
+	class XMLBindLayout
+	{
+	private:
+		std::unordered_map<std::string, std::vector<int>> slots;
+		std::vector<XMLDynamicBind> binds;	//ptr is nullptr for unused slots
+		unsigned int slotGeneration;
+	public:
+		XMLBindLayout(const std::vector<XMLDynamicBind*>& binds, unsigned int slotGeneration);
+		~XMLBindLayout();
+
+		void addSlot(const std::string& name, int slot) {
+			slots[name].push_back(slot);
+		}
+
+		//Scope with every slot pointing at the value bound in the renderer
+		XMLBindScope makeScope() const {
+			XMLBindScope scope;
+			scope.ptrs.resize(binds.size());
+			for(std::size_t i = 0; i < binds.size(); i++) {
+				scope.ptrs[i] = binds[i].ptr;
+			}
+			scope.slotGeneration = slotGeneration;
+			return scope;
+		}
+
+		//Points every slot bound to name at value, which must have the type of the bind it replaces
+		template<typename T>
+		void set(XMLBindScope& scope, const std::string& name, T& value) const {
+			if(scope.slotGeneration != slotGeneration || scope.ptrs.size() != binds.size()) {
+				throw std::runtime_error("Bind scope was not made from this layout");
+			}
+			auto named = slots.find(name);
+			if(named == slots.end()) {
+				throw std::runtime_error("No bind slot for " + name);
+			}
+			for(int slot : named->second) {
+				if(binds[slot].type != XMLBindTraits<T>::type || binds[slot].size != sizeof(T)) {
+					throw std::runtime_error("Scope value for " + name + " does not match the type " + bindTypeName(binds[slot].type) + " of its bind");
+				}
+				scope.ptrs[slot] = &value;
+			}
+		}
+	};
+
+	XMLBindLayout::XMLBindLayout(const std::vector<XMLDynamicBind*>& binds, unsigned int slotGeneration) : slotGeneration(slotGeneration)
+	{
+		this->binds.reserve(binds.size());
+		for(const XMLDynamicBind* bind : binds) {
+			this->binds.push_back(bind != nullptr ? *bind : XMLDynamicBind{.ptr = nullptr, .size = 0, .type = Float});
+		}
+	}
+
+	XMLBindLayout::~XMLBindLayout()
+	{
+	}
+
 }
 
 #endif /* DEARIMXML_XMLDYNAMICBIND_H */
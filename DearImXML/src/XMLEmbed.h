@@ -0,0 +1,41 @@
+#ifndef DEARIMXML_XMLEMBED_H
+#define DEARIMXML_XMLEMBED_H
+
+#include <stdexcept>
+#include <string>
+#include <string_view>
+#include <unordered_map>
+
+//Included by the sources imxml_embed_layouts generates, so everything here is inline
+
+namespace ImXML {
+
+	inline std::unordered_map<std::string, std::string_view>& embeddedLayouts() {
+		static std::unordered_map<std::string, std::string_view> layouts;
+		return layouts;
+	}
+
+	//Runs the registration function of a generated source before main, see cmake/ImXMLEmbed.cmake
+	struct XMLEmbeddedLayouts
+	{
+		XMLEmbeddedLayouts(void (*registration)()) {
+			registration();
+		}
+	};
+
+	//Bytes of the layout embedded from name.xml, valid for the lifetime of the program.
+	//Layouts in a static library are only found after its registration function ran.
+	inline std::string_view getEmbeddedLayout(const std::string& name) {
+		auto layout = embeddedLayouts().find(name);
+		if(layout == embeddedLayouts().end()) {
+			throw std::runtime_error("No embedded layout " + name);
+		}
+		return layout->second;
+	}
+
+}
+
+//Declares the registration function imxml_embed_layouts generates for target
+#define IMXML_EMBEDDED_LAYOUTS(target) namespace ImXML { void registerEmbeddedLayouts_##target(); }
+
+#endif /* DEARIMXML_XMLEMBED_H */
@@ -23,6 +23,16 @@ namespace ImXML {
 	XMLEventHandler::~XMLEventHandler()
 	{
 	}
+
+	//Base for handlers used with BasicXMLRenderer<Derived>: hooks are resolved at compile time,
+	//the derived class hides the ones it needs and the empty defaults compile away
+	class XMLStaticEventHandler
+	{
+	public:
+		void onNodeBegin(XMLNode&) {}
+		void onNodeEnd(XMLNode&) {}
+		void onEvent(XMLNode&) {}
+	};
 	
 }
 
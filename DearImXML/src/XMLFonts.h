@@ -0,0 +1,476 @@
+#ifndef DEARIMXML_XMLFONTS_H
+#define DEARIMXML_XMLFONTS_H
+
+#include <XMLTree.h>
+#include <XMLCache.h>
+#include <ImGuiEnum.h>
+#include <ImGUI/imgui.h>
+#include <ImGUI/imgui_internal.h>	//ImFontAtlasUpdateConfigDataPointers and ImFontAtlasBuildSetupFont
+#include <algorithm>
+#include <cmath>
+#include <cstdio>
+#include <cstdlib>
+#include <cstring>
+#include <deque>
+#include <filesystem>
+#include <mutex>
+#include <stdexcept>
+#include <string>
+#include <string_view>
+#include <thread>
+#include <vector>
+
+namespace ImXML {
+
+	//Adds the fonts a layout declares to an atlas, in document order so the first one is the default font:
+	//	<font name="cjk" src="fonts/NotoSansJP.otf" size="18" ranges="default japanese" oversample="2"/>
+	//	<font src="fonts/icons.ttf" size="18" ranges="0xe000-0xf8ff" merge="true"/>
+	//ranges lists named sets (default, greek, korean, japanese, chinese, chinese_simplified, cyrillic,
+	//thai, vietnamese) and codepoints or first-last ranges, oversample is "h" or "h v". Merged fonts add
+	//their glyphs to the previous font. <pushfont font="cjk"> renders its children with a named font.
+	//The glyph ranges are owned by the loader, keep it alive as long as the atlas may be rebuilt.
+	class XMLFontLoader
+	{
+	private:
+		std::deque<std::vector<ImWchar>> ranges;
+
+		static void appendNamed(std::vector<ImWchar>& out, const ImWchar* named) {
+			for(; named[0] != 0; named += 2) {
+				out.push_back(named[0]);
+				out.push_back(named[1]);
+			}
+		}
+
+		static ImWchar codepoint(const std::string& token, const std::string& spec) {
+			char* end;
+			unsigned long value = std::strtoul(token.c_str(), &end, 0);
+			if(token.empty() || *end != '\0' || value == 0 || value > IM_UNICODE_CODEPOINT_MAX) {
+				throw std::runtime_error("Invalid glyph range " + spec);
+			}
+			return (ImWchar)value;
+		}
+
+		//Zero terminated pairs of first and last codepoints, as ImFontConfig::GlyphRanges expects
+		static std::vector<ImWchar> parseRanges(std::string_view spec, ImFontAtlas& atlas) {
+			std::vector<ImWchar> out;
+			std::size_t i = 0;
+			while(i < spec.size()) {
+				if(spec[i] == ' ' || spec[i] == ',') {
+					i++;
+					continue;
+				}
+				std::size_t end = spec.find_first_of(" ,", i);
+				std::string token(spec.substr(i, end == std::string_view::npos ? std::string_view::npos : end - i));
+				i = end == std::string_view::npos ? spec.size() : end;
+				if(token == "default") {
+					appendNamed(out, atlas.GetGlyphRangesDefault());
+				} else if(token == "greek") {
+					appendNamed(out, atlas.GetGlyphRangesGreek());
+				} else if(token == "korean") {
+					appendNamed(out, atlas.GetGlyphRangesKorean());
+				} else if(token == "japanese") {
+					appendNamed(out, atlas.GetGlyphRangesJapanese());
+				} else if(token == "chinese") {
+					appendNamed(out, atlas.GetGlyphRangesChineseFull());
+				} else if(token == "chinese_simplified") {
+					appendNamed(out, atlas.GetGlyphRangesChineseSimplifiedCommon());
+				} else if(token == "cyrillic") {
+					appendNamed(out, atlas.GetGlyphRangesCyrillic());
+				} else if(token == "thai") {
+					appendNamed(out, atlas.GetGlyphRangesThai());
+				} else if(token == "vietnamese") {
+					appendNamed(out, atlas.GetGlyphRangesVietnamese());
+				} else {
+					std::size_t dash = token.find('-');
+					ImWchar first = codepoint(token.substr(0, dash), std::string(spec));
+					ImWchar last = dash == std::string::npos ? first : codepoint(token.substr(dash + 1), std::string(spec));
+					if(last < first) {
+						throw std::runtime_error("Invalid glyph range " + std::string(spec));
+					}
+					out.push_back(first);
+					out.push_back(last);
+				}
+			}
+			out.push_back(0);
+			return out;
+		}
+
+		//Children a lazy read deferred are only parsed when their text declares a font
+		static void collect(XMLTree& tree, XMLNode& node, std::vector<const XMLNode*>& fonts) {
+			if(node.type == ImGuiEnum::FONT) {
+				fonts.push_back(&node);
+			}
+			if(tree.getDeferred(node).find("<font") != std::string_view::npos) {
+				tree.materialize(node);
+			}
+			for(auto child : node.children) {
+				collect(tree, *child, fonts);
+			}
+		}
+
+		void add(const XMLNode& node, ImFontAtlas& atlas, const std::filesystem::path& directory) {
+			std::string src = node.args["src"].str();
+			if(src.empty()) {
+				throw std::runtime_error("Font without src");
+			}
+			std::filesystem::path path = directory / std::filesystem::u8path(src);
+			XMLMappedFile file(path.string());
+			if(!file.isOpen() || file.view().empty()) {
+				throw std::runtime_error("Cannot open font " + path.string());
+			}
+			float size = std::strtof(node.args["size"].c_str(), nullptr);
+			if(!(size > 0.0f)) {
+				throw std::runtime_error("Font " + src + " needs a size");
+			}
+
+			ImFontConfig config;
+			XMLString name = node.args["name"];
+			std::snprintf(config.Name, sizeof(config.Name), "%s", name.empty() ? path.filename().string().c_str() : name.c_str());
+			config.MergeMode = node.args["merge"] == "true";
+			config.PixelSnapH = node.args["pixelsnap"] == "true";
+			XMLString oversample = node.args["oversample"];
+			if(!oversample.empty()) {
+				char* end;
+				config.OversampleH = std::max(1, (int)std::strtol(oversample.c_str(), &end, 10));
+				config.OversampleV = *end != '\0' ? std::max(1, (int)std::strtol(end, nullptr, 10)) : config.OversampleV;
+			}
+			XMLString spec = node.args["ranges"];
+			if(!spec.empty()) {
+				ranges.push_back(parseRanges(spec, atlas));
+				config.GlyphRanges = ranges.back().data();
+			}
+			if(config.MergeMode && atlas.Fonts.empty()) {
+				throw std::runtime_error("Font " + src + " has no font to merge into");
+			}
+			//The atlas owns and frees the copy
+			std::string_view data = file.view();
+			void* copy = IM_ALLOC(data.size());
+			std::memcpy(copy, data.data(), data.size());
+			atlas.AddFontFromMemoryTTF(copy, (int)data.size(), size, &config);
+		}
+	public:
+		XMLFontLoader();
+		~XMLFontLoader();
+
+		//Adds every <font> of tree to atlas, src is relative to directory. Call before the atlas is built,
+		//with XMLFontCache::build to skip rasterizing on later launches. Lazy subtrees that declare fonts
+		//are materialized, the others stay deferred.
+		void load(XMLTree& tree, ImFontAtlas& atlas, const std::string& directory = "") {
+			std::vector<const XMLNode*> fonts;
+			collect(tree, tree.getRoot(), fonts);
+			for(const XMLNode* font : fonts) {
+				add(*font, atlas, std::filesystem::u8path(directory));
+			}
+		}
+	};
+
+	XMLFontLoader::XMLFontLoader()
+	{
+	}
+
+	XMLFontLoader::~XMLFontLoader()
+	{
+	}
+
+	//Directory of built font atlases. An entry holds the atlas pixels, the glyphs of every font and the
+	//packed custom rectangles, keyed by the bytes and settings of every font (size, glyph ranges,
+	//oversampling...) and by the atlas settings. A hit restores the atlas without rasterizing any glyph.
+	class XMLFontCache
+	{
+	private:
+		//Bump when the file layout changes
+		static constexpr uint32_t formatVersion = 1;
+		static constexpr uint32_t magic = 0x46584d49; //"IMXF"
+
+		std::filesystem::path directory;
+		std::mutex mutex;
+		XMLCacheStats stats;
+
+		std::filesystem::path entryPath(uint64_t key) const {
+			char name[32];
+			std::snprintf(name, sizeof(name), "%016llx.imxf", (unsigned long long)key);
+			return directory / name;
+		}
+
+		template<typename T>
+		static void put(std::string& out, T value) {
+			out.append(reinterpret_cast<const char*>(&value), sizeof(T));
+		}
+
+		template<typename T>
+		static T get(std::string_view data, std::size_t& offset) {
+			if(offset + sizeof(T) > data.size()) {
+				throw std::runtime_error("Truncated font cache entry");
+			}
+			T value;
+			std::memcpy(&value, data.data() + offset, sizeof(T));
+			offset += sizeof(T);
+			return value;
+		}
+
+		static int fontIndex(const ImFontAtlas& atlas, const ImFont* font) {
+			for(int i = 0; i < atlas.Fonts.Size; i++) {
+				if(atlas.Fonts[i] == font) {
+					return i;
+				}
+			}
+			return -1;
+		}
+
+		static void putRect(std::string& out, const ImFontAtlas& atlas, const ImFontAtlasCustomRect& rect) {
+			put<uint16_t>(out, rect.Width);
+			put<uint16_t>(out, rect.Height);
+			put<uint32_t>(out, rect.GlyphID);
+			put<float>(out, rect.GlyphAdvanceX);
+			put<ImVec2>(out, rect.GlyphOffset);
+			put<int32_t>(out, fontIndex(atlas, rect.Font));
+		}
+
+		struct Font
+		{
+			float size, ascent, descent;
+			int surface;
+			std::vector<ImFontGlyph> glyphs;
+		};
+
+		bool restore(std::string_view data, uint64_t key, ImFontAtlas& atlas) {
+			std::size_t offset = 0;
+			if(get<uint32_t>(data, offset) != magic || get<uint32_t>(data, offset) != formatVersion || get<uint64_t>(data, offset) != key) {
+				return false;
+			}
+			//Everything is read before the atlas is touched, so a damaged entry leaves it as it was
+			int width = get<int32_t>(data, offset);
+			int height = get<int32_t>(data, offset);
+			ImVec2 whitePixel = get<ImVec2>(data, offset);
+			ImVec4 lines[IM_DRAWLIST_TEX_LINES_WIDTH_MAX + 1];
+			for(ImVec4& line : lines) {
+				line = get<ImVec4>(data, offset);
+			}
+			int packIdCursors = get<int32_t>(data, offset);
+			int packIdLines = get<int32_t>(data, offset);
+			uint32_t rectCount = get<uint32_t>(data, offset);
+			if(width <= 0 || height <= 0 || rectCount > data.size()) {
+				throw std::runtime_error("Invalid font cache entry");
+			}
+			std::vector<ImFontAtlasCustomRect> rects(rectCount);
+			for(ImFontAtlasCustomRect& rect : rects) {
+				rect.Width = get<uint16_t>(data, offset);
+				rect.Height = get<uint16_t>(data, offset);
+				rect.X = get<uint16_t>(data, offset);
+				rect.Y = get<uint16_t>(data, offset);
+				rect.GlyphID = get<uint32_t>(data, offset);
+				rect.GlyphAdvanceX = get<float>(data, offset);
+				rect.GlyphOffset = get<ImVec2>(data, offset);
+				int font = get<int32_t>(data, offset);
+				if(font >= atlas.Fonts.Size) {
+					throw std::runtime_error("Invalid font cache entry");
+				}
+				rect.Font = font >= 0 ? atlas.Fonts[font] : nullptr;
+			}
+			if(get<uint32_t>(data, offset) != (uint32_t)atlas.Fonts.Size) {
+				throw std::runtime_error("Invalid font cache entry");
+			}
+			std::vector<Font> fonts(atlas.Fonts.Size);
+			for(Font& font : fonts) {
+				font.size = get<float>(data, offset);
+				font.ascent = get<float>(data, offset);
+				font.descent = get<float>(data, offset);
+				font.surface = get<int32_t>(data, offset);
+				uint32_t glyphs = get<uint32_t>(data, offset);
+				if(glyphs == 0 || glyphs >= 0xFFFF || offset + glyphs * sizeof(ImFontGlyph) > data.size()) {
+					throw std::runtime_error("Invalid font cache entry");
+				}
+				font.glyphs.resize(glyphs);
+				std::memcpy(font.glyphs.data(), data.data() + offset, glyphs * sizeof(ImFontGlyph));
+				offset += glyphs * sizeof(ImFontGlyph);
+			}
+			std::size_t pixels = (std::size_t)width * height;
+			if(offset + pixels != data.size()) {
+				throw std::runtime_error("Invalid font cache entry");
+			}
+
+			atlas.ClearTexData();
+			atlas.CustomRects.resize(rects.size());
+			std::copy(rects.begin(), rects.end(), atlas.CustomRects.begin());
+			atlas.PackIdMouseCursors = packIdCursors;
+			atlas.PackIdLines = packIdLines;
+			//Same font setup as Build, so ConfigData and ConfigDataCount match a cold build
+			ImFontAtlasUpdateConfigDataPointers(&atlas);
+			for(ImFontConfig& config : atlas.ConfigData) {
+				if(!config.MergeMode) {
+					const Font& font = fonts[fontIndex(atlas, config.DstFont)];
+					ImFontAtlasBuildSetupFont(&atlas, config.DstFont, &config, font.ascent, font.descent);
+				}
+			}
+			for(int i = 0; i < atlas.Fonts.Size; i++) {
+				ImFont* font = atlas.Fonts[i];
+				font->FontSize = fonts[i].size;
+				font->MetricsTotalSurface = fonts[i].surface;
+				font->Glyphs.resize(fonts[i].glyphs.size());
+				std::copy(fonts[i].glyphs.begin(), fonts[i].glyphs.end(), font->Glyphs.begin());
+				font->BuildLookupTable();
+			}
+			atlas.TexPixelsAlpha8 = static_cast<unsigned char*>(IM_ALLOC(pixels));
+			std::memcpy(atlas.TexPixelsAlpha8, data.data() + offset, pixels);
+			atlas.TexWidth = width;
+			atlas.TexHeight = height;
+			atlas.TexUvScale = ImVec2(1.0f / width, 1.0f / height);
+			atlas.TexUvWhitePixel = whitePixel;
+			std::memcpy(atlas.TexUvLines, lines, sizeof(lines));
+			atlas.TexReady = true;
+			return true;
+		}
+
+		void store(uint64_t key, ImFontAtlas& atlas) {
+			unsigned char* pixels;
+			int width, height;
+			atlas.GetTexDataAsAlpha8(&pixels, &width, &height);
+			if(pixels == nullptr || atlas.TexPixelsUseColors) {
+				return;	//colored glyphs only exist in the RGBA32 texture
+			}
+			std::string out;
+			put<uint32_t>(out, magic);
+			put<uint32_t>(out, formatVersion);
+			put<uint64_t>(out, key);
+			put<int32_t>(out, width);
+			put<int32_t>(out, height);
+			put<ImVec2>(out, atlas.TexUvWhitePixel);
+			for(const ImVec4& line : atlas.TexUvLines) {
+				put<ImVec4>(out, line);
+			}
+			put<int32_t>(out, atlas.PackIdMouseCursors);
+			put<int32_t>(out, atlas.PackIdLines);
+			put<uint32_t>(out, atlas.CustomRects.Size);
+			for(const ImFontAtlasCustomRect& rect : atlas.CustomRects) {
+				put<uint16_t>(out, rect.Width);
+				put<uint16_t>(out, rect.Height);
+				put<uint16_t>(out, rect.X);
+				put<uint16_t>(out, rect.Y);
+				put<uint32_t>(out, rect.GlyphID);
+				put<float>(out, rect.GlyphAdvanceX);
+				put<ImVec2>(out, rect.GlyphOffset);
+				put<int32_t>(out, fontIndex(atlas, rect.Font));
+			}
+			put<uint32_t>(out, atlas.Fonts.Size);
+			for(const ImFont* font : atlas.Fonts) {
+				put<float>(out, font->FontSize);
+				put<float>(out, font->Ascent);
+				put<float>(out, font->Descent);
+				put<int32_t>(out, font->MetricsTotalSurface);
+				put<uint32_t>(out, font->Glyphs.Size);
+				out.append(reinterpret_cast<const char*>(font->Glyphs.Data), font->Glyphs.size_in_bytes());
+			}
+			out.append(reinterpret_cast<const char*>(pixels), (std::size_t)width * height);
+
+			std::error_code ec;
+			std::filesystem::create_directories(directory, ec);
+			writeEntry(entryPath(key), out);
+		}
+	public:
+		XMLFontCache(const std::string& directory);
+		~XMLFontCache();
+
+		//Key of the atlas as configured, before it is built
+		static uint64_t key(ImFontAtlas& atlas) {
+			std::string settings;
+			put<uint32_t>(settings, formatVersion);
+			put<uint32_t>(settings, IMGUI_VERSION_NUM);
+			put<uint32_t>(settings, sizeof(ImFontGlyph));
+#ifdef IMGUI_ENABLE_FREETYPE
+			put<uint32_t>(settings, 1);
+#endif
+			put<int32_t>(settings, atlas.Flags);
+			put<int32_t>(settings, atlas.TexDesiredWidth);
+			put<int32_t>(settings, atlas.TexGlyphPadding);
+			put<uint32_t>(settings, atlas.FontBuilderFlags);
+			uint64_t hash = 0;
+			for(const ImFontConfig& config : atlas.ConfigData) {
+				hash = hashBytes(std::string_view(static_cast<const char*>(config.FontData), config.FontDataSize), hash);
+				put<int32_t>(settings, config.FontNo);
+				put<float>(settings, config.SizePixels);
+				put<int32_t>(settings, config.OversampleH);
+				put<int32_t>(settings, config.OversampleV);
+				put<uint8_t>(settings, config.PixelSnapH);
+				put<ImVec2>(settings, config.GlyphExtraSpacing);
+				put<ImVec2>(settings, config.GlyphOffset);
+				put<float>(settings, config.GlyphMinAdvanceX);
+				put<float>(settings, config.GlyphMaxAdvanceX);
+				put<uint8_t>(settings, config.MergeMode);
+				put<uint32_t>(settings, config.FontBuilderFlags);
+				put<float>(settings, config.RasterizerMultiply);
+				put<uint32_t>(settings, config.EllipsisChar);
+				put<int32_t>(settings, fontIndex(atlas, config.DstFont));
+				for(const ImWchar* range = config.GlyphRanges != nullptr ? config.GlyphRanges : atlas.GetGlyphRangesDefault(); *range != 0; range++) {
+					put<uint32_t>(settings, *range);
+				}
+				put<uint32_t>(settings, 0);
+			}
+			for(const ImFontAtlasCustomRect& rect : atlas.CustomRects) {
+				putRect(settings, atlas, rect);
+			}
+			return hashBytes(settings, hash);
+		}
+
+		//Builds atlas like ImFontAtlas::Build, from the cache when an entry matches. Returns true on a hit.
+		//Call once the fonts are added and before the renderer backend uploads the texture.
+		bool build(ImFontAtlas& atlas) {
+			if(atlas.ConfigData.Size == 0) {
+				atlas.AddFontDefault();
+			}
+			//Build rounds the sizes down first, the key must match the sizes the atlas is built with
+			for(ImFontConfig& config : atlas.ConfigData) {
+				config.SizePixels = std::floor(config.SizePixels);
+			}
+			uint64_t key = XMLFontCache::key(atlas);
+			std::filesystem::path path = entryPath(key);
+			bool hit = false;
+			{
+				XMLMappedFile file(path.string());
+				if(file.isOpen()) {
+					try {
+						hit = restore(file.view(), key, atlas);
+					} catch(const std::runtime_error&) {
+						//Damaged entries are treated as a miss and overwritten below
+					}
+				}
+			}
+			if(!hit) {
+				atlas.Build();
+				store(key, atlas);
+			}
+			std::lock_guard<std::mutex> lock(mutex);
+			if(hit) {
+				stats.hits++;
+			} else {
+				stats.misses++;
+			}
+			return hit;
+		}
+
+		XMLCacheStats getStats() {
+			std::lock_guard<std::mutex> lock(mutex);
+			return stats;
+		}
+
+		void clear() {
+			std::lock_guard<std::mutex> lock(mutex);
+			std::error_code ec;
+			for(const auto& entry : std::filesystem::directory_iterator(directory, ec)) {
+				if(entry.path().extension() == ".imxf") {
+					std::filesystem::remove(entry.path(), ec);
+				}
+			}
+		}
+	};
+
+	XMLFontCache::XMLFontCache(const std::string& directory) : directory(directory)
+	{
+	}
+
+	XMLFontCache::~XMLFontCache()
+	{
+	}
+
+}
+
+#endif /* DEARIMXML_XMLFONTS_H */
@@ -0,0 +1,314 @@
+#ifndef DEARIMXML_XMLHOTRELOAD_H
+#define DEARIMXML_XMLHOTRELOAD_H
+
+#include <XMLTree.h>
+#include <XMLReader.h>
+#include <XMLCache.h>
+#include <ImGuiEnum.h>
+#include <array>
+#include <atomic>
+#include <chrono>
+#include <filesystem>
+#include <memory>
+#include <mutex>
+#include <stdexcept>
+#include <string>
+#include <thread>
+#include <vector>
+
+#ifdef __linux__
+#include <poll.h>
+#include <sys/inotify.h>
+#include <unistd.h>
+#endif
+
+namespace ImXML {
+
+	struct XMLPatchStats
+	{
+		unsigned int updated = 0;
+		unsigned int inserted = 0;
+		unsigned int removed = 0;
+		unsigned int moved = 0;
+		bool replaced = false;	//the root changed type and the whole tree was swapped
+	};
+
+	//Copies a source subtree under parent through the mutation API, so the new nodes get linked on the next render.
+	//Children the reload deferred stay deferred in the copy.
+	inline void copySubtree(XMLTree& tree, XMLNodeHandle parent, std::size_t position, const XMLTree& sourceTree, const XMLNode& source, XMLPatchStats& stats) {
+		XMLNodeHandle node = tree.insert(parent, source.type, position);
+		for(const auto& arg : source.args) {
+			tree.setAttribute(node, arg.first, arg.second);
+		}
+		tree.setFlags(node, source.flags);
+		stats.inserted++;
+		if(XMLTree::isLazy(source)) {
+			tree.defer(node, sourceTree, source);
+		}
+		for(auto child : source.children) {
+			copySubtree(tree, node, SIZE_MAX, sourceTree, *child, stats);
+		}
+	}
+
+	//Makes live match source, keeping every node that can be matched so its bind slot, route and
+	//ImGui state stay as they are. Only changed nodes are marked dirty and relinked.
+	inline void patchNode(XMLTree& tree, XMLNode& live, XMLTree& sourceTree, XMLNode& source, XMLPatchStats& stats) {
+		XMLNodeHandle handle = tree.handle(live);
+		bool changed = false;
+		for(const auto& arg : source.args) {
+			auto current = live.args.find(arg.first);
+			if(current == live.args.end() || current->second != arg.second) {
+				tree.setAttribute(handle, arg.first, arg.second);
+				changed = true;
+			}
+		}
+		std::vector<std::string> stale;
+		for(const auto& arg : live.args) {
+			if(source.args.find(arg.first) == source.args.end()) {
+				stale.push_back(arg.first.str());
+			}
+		}
+		for(const std::string& key : stale) {
+			tree.removeAttribute(handle, key);
+			changed = true;
+		}
+		if(live.flags != source.flags) {
+			tree.setFlags(handle, source.flags);
+			changed = true;
+		}
+
+		//Children that were never shown have no state to keep, they take the new text without being parsed
+		if(XMLTree::isLazy(live)) {
+			if(!XMLTree::isLazy(source) || tree.getDeferred(live) != sourceTree.getDeferred(source)) {
+				tree.defer(handle, sourceTree, source);
+				changed = true;
+			}
+			stats.updated += changed;
+			if(!XMLTree::isLazy(live)) {
+				for(std::size_t i = 0; i < source.children.size(); i++) {
+					copySubtree(tree, handle, i, sourceTree, *source.children[i], stats);
+				}
+			}
+			return;
+		}
+		//Shown children are compared like any other, the reload parses the ones it deferred
+		sourceTree.materialize(source);
+		stats.updated += changed;
+
+		//Children are matched by id first, the rest by their order among live children of the same tag
+		std::vector<XMLNode*> matched(source.children.size(), nullptr);
+		std::vector<XMLNode*> unused(live.children.begin(), live.children.end());
+		auto take = [&unused](XMLNode* node, std::size_t position) {
+			//Unchanged layouts keep their nodes in place, only search when the node moved
+			if(position < unused.size() && unused[position] == node) {
+				unused[position] = nullptr;
+				return true;
+			}
+			auto found = std::find(unused.begin(), unused.end(), node);
+			if(found == unused.end()) {
+				return false;
+			}
+			*found = nullptr;
+			return true;
+		};
+		for(std::size_t i = 0; i < source.children.size(); i++) {
+			const XMLNode& child = *source.children[i];
+			auto id = child.args.find("id");
+			if(id != child.args.end()) {
+				XMLNode* node = tree.find(id->second);
+				if(node != nullptr && node->parent == &live && node->type == child.type && take(node, i)) {
+					matched[i] = node;
+				}
+			}
+		}
+		std::array<std::size_t, IMGUIENUM_COUNT> cursor = {};
+		for(std::size_t i = 0; i < source.children.size(); i++) {
+			if(matched[i] != nullptr) {
+				continue;
+			}
+			ImGuiEnum type = source.children[i]->type;
+			for(std::size_t& j = cursor[type]; j < unused.size(); j++) {
+				if(unused[j] != nullptr && unused[j]->type == type) {
+					matched[i] = unused[j];
+					unused[j++] = nullptr;
+					break;
+				}
+			}
+		}
+		for(XMLNode* node : unused) {
+			if(node != nullptr) {
+				tree.remove(tree.handle(*node));
+				stats.removed++;
+			}
+		}
+		for(std::size_t i = 0; i < source.children.size(); i++) {
+			if(matched[i] == nullptr) {
+				copySubtree(tree, handle, i, sourceTree, *source.children[i], stats);
+				continue;
+			}
+			if(live.children[i] != matched[i]) {
+				tree.move(tree.handle(*matched[i]), handle, i);
+				stats.moved++;
+			}
+			patchNode(tree, *matched[i], sourceTree, *source.children[i], stats);
+		}
+	}
+
+	//Applies the difference between two parses of a layout to the live tree, must not be called while rendering.
+	//Falls back to replacing the tree, which is then fully relinked, when the root tag changed.
+	inline XMLPatchStats patchTree(XMLTree& live, XMLTree& source) {
+		XMLPatchStats stats;
+		if(live.getRoot().type != source.getRoot().type) {
+			live = std::move(source);
+			stats.replaced = true;
+			return stats;
+		}
+		patchNode(live, live.getRoot(), source, source.getRoot(), stats);
+		return stats;
+	}
+
+	//Opt-in watcher that reparses a layout on a background thread whenever the file is written.
+	//Uses inotify on Linux and polls the modification time elsewhere. Call apply between frames.
+	//Each reparse interns into a pool of its own that is freed once applied, only the strings patchNode
+	//changes go to the pool of the live tree, which still grows by those as pools never shrink.
+	class XMLHotReload
+	{
+	private:
+		std::string filename;
+		//Copy of the settings of the reader that loaded the live tree without its string pool, only used by the worker
+		XMLReader reader;
+		std::atomic<bool> running{true};
+		std::mutex mutex;
+		std::unique_ptr<XMLTree> parsed;	//latest successful parse not yet applied
+		std::string error;
+		std::thread worker;
+
+		//Editors often write a file in several steps, wait until it was quiet for a moment
+		static constexpr int settleMs = 50;
+		static constexpr int pollMs = 100;
+
+		void reparse() {
+			try {
+				//Copied rather than mapped, the editor may truncate the file while it is parsed
+				XMLMappedFile file(filename, false);
+				if(!file.isOpen()) {
+					throw std::runtime_error("Cannot open " + filename);
+				}
+				auto tree = std::make_unique<XMLTree>(reader.readBuffer(file.view()));
+				std::lock_guard<std::mutex> lock(mutex);
+				parsed = std::move(tree);
+				error.clear();
+			} catch(const std::exception& e) {
+				//Half saved or invalid layouts keep the live tree until the next write
+				std::lock_guard<std::mutex> lock(mutex);
+				error = e.what();
+			}
+		}
+
+		void watch();
+	public:
+		//Reparses with the settings of reader, a shared cache must outlive the watcher. A layout whose root
+		//changed type replaces the live tree, which then keeps the private pool of the reparse.
+		XMLHotReload(const std::string& filename, const XMLReader& reader = XMLReader());
+		~XMLHotReload();
+
+		XMLHotReload(const XMLHotReload&) = delete;
+		XMLHotReload& operator=(const XMLHotReload&) = delete;
+
+		//Patches tree with the latest reload, returns false when there was nothing to apply
+		bool apply(XMLTree& tree, XMLPatchStats* stats = nullptr) {
+			std::unique_ptr<XMLTree> source;
+			{
+				std::lock_guard<std::mutex> lock(mutex);
+				source = std::move(parsed);
+			}
+			if(source == nullptr) {
+				return false;
+			}
+			XMLPatchStats result = patchTree(tree, *source);
+			if(stats != nullptr) {
+				*stats = result;
+			}
+			return true;
+		}
+
+		//Message of the last failed reparse, empty once a reparse succeeds
+		std::string getError() {
+			std::lock_guard<std::mutex> lock(mutex);
+			return error;
+		}
+	};
+
+	XMLHotReload::XMLHotReload(const std::string& filename, const XMLReader& settings) : filename(filename), reader(settings.configured(true))
+	{
+		reader.setStringPool(nullptr);
+		worker = std::thread(&XMLHotReload::watch, this);
+	}
+
+	XMLHotReload::~XMLHotReload()
+	{
+		running = false;
+		worker.join();
+	}
+
+#ifdef __linux__
+	void XMLHotReload::watch() {
+		//Watch the directory, editors commonly save by writing a new file and renaming it over the old one
+		std::filesystem::path path = std::filesystem::absolute(filename);
+		int fd = inotify_init1(IN_NONBLOCK | IN_CLOEXEC);
+		if(fd < 0) {
+			std::lock_guard<std::mutex> lock(mutex);
+			error = "inotify_init1 failed";
+			return;
+		}
+		if(inotify_add_watch(fd, path.parent_path().c_str(), IN_CLOSE_WRITE | IN_MOVED_TO | IN_CREATE) < 0) {
+			close(fd);
+			std::lock_guard<std::mutex> lock(mutex);
+			error = "Cannot watch " + path.parent_path().string();
+			return;
+		}
+		std::string name = path.filename().string();
+		alignas(inotify_event) char buffer[4096];
+		bool changed = false;
+		while(running) {
+			pollfd descriptor = {fd, POLLIN, 0};
+			int ready = poll(&descriptor, 1, changed ? settleMs : pollMs);
+			if(ready == 0 && changed) {
+				changed = false;
+				reparse();
+				continue;
+			}
+			if(ready <= 0) {
+				continue;
+			}
+			ssize_t length;
+			while((length = read(fd, buffer, sizeof(buffer))) > 0) {
+				for(char* event = buffer; event < buffer + length; event += sizeof(inotify_event) + reinterpret_cast<inotify_event*>(event)->len) {
+					inotify_event* info = reinterpret_cast<inotify_event*>(event);
+					if(info->len > 0 && name == info->name) {
+						changed = true;
+					}
+				}
+			}
+		}
+		close(fd);
+	}
+#else
+	void XMLHotReload::watch() {
+		std::error_code ec;
+		auto modified = std::filesystem::last_write_time(filename, ec);
+		while(running) {
+			std::this_thread::sleep_for(std::chrono::milliseconds(pollMs));
+			auto time = std::filesystem::last_write_time(filename, ec);
+			if(!ec && time != modified) {
+				modified = time;
+				std::this_thread::sleep_for(std::chrono::milliseconds(settleMs));
+				reparse();
+			}
+		}
+	}
+#endif
+
+}
+
+#endif /* DEARIMXML_XMLHOTRELOAD_H */
@@ -0,0 +1,195 @@
+#ifndef DEARIMXML_XMLINDEX_H
+#define DEARIMXML_XMLINDEX_H
+
+#include <cstdint>
+#include <string_view>
+#include <utility>
+#include <vector>
+
+namespace ImXML {
+
+	struct XMLNode;
+
+	inline uint32_t hashString(std::string_view str) {
+		//FNV-1a
+		uint32_t hash = 2166136261u;
+		for(char c : str) {
+			hash = (hash ^ (unsigned char)c) * 16777619u;
+		}
+		return hash;
+	}
+
+	//Flat open addressing table from id to node with linear probing. Keys view the id strings
+	//stored in the nodes, so an entry must be removed before the id of its node changes.
+	//Nodes hidden by a later node with the same id are kept aside and found again once it is removed.
+	class XMLIdIndex
+	{
+	private:
+		struct Entry
+		{
+			std::string_view key;
+			uint32_t hash;
+			XMLNode* node;	//nullptr for empty slots, tombstone for removed ones
+		};
+
+		static XMLNode* tombstone() {
+			return reinterpret_cast<XMLNode*>(uintptr_t(1));
+		}
+
+		std::vector<Entry> entries;
+		std::size_t used = 0;	//live entries and tombstones
+		//Nodes replaced by a later one with the same id, in insertion order. Duplicate ids are rare.
+		std::vector<std::pair<std::string_view, XMLNode*>> hidden;
+
+		std::size_t mask() const {
+			return entries.size() - 1;
+		}
+
+		void grow() {
+			std::vector<Entry> old;
+			old.swap(entries);
+			//Sized from the live entries, so tables full of tombstones are cleaned rather than doubled
+			std::size_t live = 0;
+			for(const Entry& entry : old) {
+				live += entry.node != nullptr && entry.node != tombstone();
+			}
+			std::size_t capacity = 16;
+			while(capacity < (live + 1) * 4) {
+				capacity *= 2;
+			}
+			entries.assign(capacity, Entry{std::string_view(), 0, nullptr});
+			used = 0;
+			for(const Entry& entry : old) {
+				if(entry.node != nullptr && entry.node != tombstone()) {
+					insert(entry.key, entry.node, entry.hash);
+				}
+			}
+		}
+
+		void insert(std::string_view key, XMLNode* node, uint32_t hash) {
+			std::size_t reuse = SIZE_MAX;
+			for(std::size_t i = hash & mask();; i = (i + 1) & mask()) {
+				Entry& entry = entries[i];
+				if(entry.node == nullptr) {
+					if(reuse == SIZE_MAX) {
+						used++;
+						reuse = i;
+					}
+					entries[reuse] = {key, hash, node};
+					return;
+				}
+				if(entry.node == tombstone()) {
+					if(reuse == SIZE_MAX) {
+						reuse = i;
+					}
+				} else if(entry.hash == hash && entry.key == key) {
+					if(entry.node != node) {
+						hidden.emplace_back(entry.key, entry.node);
+					}
+					entry = {key, hash, node};
+					return;
+				}
+			}
+		}
+
+		//Puts the latest node hidden under the key of entry back in it, returns false if there is none
+		bool unhide(Entry& entry) {
+			for(std::size_t i = hidden.size(); i-- > 0;) {
+				if(hidden[i].first == entry.key) {
+					//The key views the id of the node it belongs to
+					entry.key = hidden[i].first;
+					entry.node = hidden[i].second;
+					hidden.erase(hidden.begin() + i);
+					return true;
+				}
+			}
+			return false;
+		}
+	public:
+		XMLIdIndex();
+		~XMLIdIndex();
+
+		//A later node with the same id hides the earlier one until it is removed
+		void insert(std::string_view key, XMLNode* node) {
+			if((used + 1) * 2 > entries.size()) {
+				grow();
+			}
+			insert(key, node, hashString(key));
+		}
+
+		//Removes node, the latest node it hid with the same id takes its place
+		void erase(std::string_view key, XMLNode* node) {
+			if(entries.empty()) {
+				return;
+			}
+			uint32_t hash = hashString(key);
+			for(std::size_t i = hash & mask(); entries[i].node != nullptr; i = (i + 1) & mask()) {
+				Entry& entry = entries[i];
+				if(entry.node != tombstone() && entry.hash == hash && entry.key == key) {
+					if(entry.node != node) {
+						for(auto it = hidden.begin(); it != hidden.end(); ++it) {
+							if(it->second == node) {
+								hidden.erase(it);
+								break;
+							}
+						}
+						return;
+					}
+					if(!unhide(entry)) {
+						entry.node = tombstone();
+					}
+					return;
+				}
+			}
+		}
+
+		XMLNode* find(std::string_view key) const {
+			if(entries.empty()) {
+				return nullptr;
+			}
+			uint32_t hash = hashString(key);
+			for(std::size_t i = hash & mask(); entries[i].node != nullptr; i = (i + 1) & mask()) {
+				const Entry& entry = entries[i];
+				if(entry.node != tombstone() && entry.hash == hash && entry.key == key) {
+					return entry.node;
+				}
+			}
+			return nullptr;
+		}
+
+		//Appends every node with this id, the one find returns first and then the hidden ones
+		void findAll(std::string_view key, std::vector<XMLNode*>& out) const {
+			XMLNode* node = find(key);
+			if(node == nullptr) {
+				return;
+			}
+			out.push_back(node);
+			for(const auto& entry : hidden) {
+				if(entry.first == key) {
+					out.push_back(entry.second);
+				}
+			}
+		}
+
+		std::size_t getMemoryUsage() const {
+			return entries.capacity() * sizeof(Entry) + hidden.capacity() * sizeof(hidden[0]);
+		}
+
+		void clear() {
+			entries.clear();
+			hidden.clear();
+			used = 0;
+		}
+	};
+
+	XMLIdIndex::XMLIdIndex()
+	{
+	}
+
+	XMLIdIndex::~XMLIdIndex()
+	{
+	}
+
+}
+
+#endif /* DEARIMXML_XMLINDEX_H */
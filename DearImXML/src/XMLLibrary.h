@@ -0,0 +1,194 @@
+#ifndef DEARIMXML_XMLLIBRARY_H
+#define DEARIMXML_XMLLIBRARY_H
+
+#include <XMLTree.h>
+#include <XMLReader.h>
+#include <XMLStringPool.h>
+#include <algorithm>
+#include <atomic>
+#include <exception>
+#include <filesystem>
+#include <fstream>
+#include <memory>
+#include <stdexcept>
+#include <string>
+#include <thread>
+#include <unordered_map>
+#include <vector>
+
+namespace ImXML {
+
+	struct XMLLayoutMemory
+	{
+		std::string name;
+		std::size_t nodes;
+		std::size_t bytes;	//nodes and indexes, the shared strings are counted once in the total
+	};
+
+	struct XMLLibraryMemory
+	{
+		std::vector<XMLLayoutMemory> layouts;
+		std::size_t treeBytes = 0;
+		std::size_t stringBytes = 0;
+		std::size_t strings = 0;
+		std::size_t savedBytes = 0;	//strings deduplicated by the shared pool
+		std::size_t totalBytes = 0;
+	};
+
+	//Set of layouts loaded in parallel into one shared string pool, fetched by the file name without extension
+	class XMLLibrary
+	{
+	private:
+		std::shared_ptr<XMLStringPool> strings = std::make_shared<XMLStringPool>();
+		std::unordered_map<std::string, XMLTree> trees;
+		unsigned int threads = 0;
+		XMLLayoutCache* cache = nullptr;
+	public:
+		XMLLibrary();
+		~XMLLibrary();
+
+		//Loads every file, each one on a single thread and several at once. Throws the error of the first
+		//file in the list that failed, the layouts of the other files are still added.
+		void load(const std::vector<std::string>& files);
+
+		//Every .xml file in a directory, not recursive
+		void loadDirectory(const std::string& directory);
+
+		//Text file with one layout path per line, relative to the manifest. Empty lines and lines starting with # are skipped.
+		void loadManifest(const std::string& manifest);
+
+		//nullptr when no layout has this name
+		XMLTree* find(const std::string& name) {
+			auto tree = trees.find(name);
+			return tree != trees.end() ? &tree->second : nullptr;
+		}
+
+		XMLTree& get(const std::string& name) {
+			XMLTree* tree = find(name);
+			if(tree == nullptr) {
+				throw std::runtime_error("Unknown layout " + name);
+			}
+			return *tree;
+		}
+
+		std::size_t size() const {
+			return trees.size();
+		}
+
+		//Threads used to load files, 0 uses every core
+		void setThreads(unsigned int count) {
+			threads = count;
+		}
+
+		//Parse cache shared by the loader threads, nullptr disables caching
+		void setCache(XMLLayoutCache* layoutCache) {
+			cache = layoutCache;
+		}
+
+		XMLStringPool& getStrings() {
+			return *strings;
+		}
+
+		//Walks every node of every layout (see XMLTree::getMemoryUsage), meant for diagnostics rather than
+		//every frame
+		XMLLibraryMemory getMemoryUsage();
+	};
+
+	XMLLibrary::XMLLibrary()
+	{
+	}
+
+	XMLLibrary::~XMLLibrary()
+	{
+	}
+
+	void XMLLibrary::load(const std::vector<std::string>& files) {
+		std::vector<std::unique_ptr<XMLTree>> loaded(files.size());
+		std::vector<std::exception_ptr> errors(files.size());
+		std::atomic<std::size_t> next{0};
+		auto work = [&]() {
+			XMLReader reader;
+			reader.setThreads(1);
+			reader.setStringPool(strings);
+			reader.setCache(cache);
+			for(std::size_t file; (file = next++) < files.size();) {
+				try {
+					loaded[file] = std::make_unique<XMLTree>(reader.read(files[file]));
+				} catch(const std::exception& e) {
+					errors[file] = std::make_exception_ptr(std::runtime_error(files[file] + ": " + e.what()));
+				}
+			}
+		};
+		unsigned int count = threads > 0 ? threads : std::max(1u, std::thread::hardware_concurrency());
+		std::vector<std::thread> pool;
+		for(unsigned int t = 1; t < std::min<std::size_t>(count, files.size()); t++) {
+			pool.emplace_back(work);
+		}
+		work();
+		for(auto& thread : pool) {
+			thread.join();
+		}
+
+		for(std::size_t file = 0; file < files.size(); file++) {
+			if(loaded[file] != nullptr) {
+				trees.insert_or_assign(std::filesystem::path(files[file]).stem().string(), std::move(*loaded[file]));
+			}
+		}
+		for(auto& error : errors) {
+			if(error) {
+				std::rethrow_exception(error);
+			}
+		}
+	}
+
+	void XMLLibrary::loadDirectory(const std::string& directory) {
+		std::vector<std::string> files;
+		for(const auto& entry : std::filesystem::directory_iterator(directory)) {
+			if(entry.is_regular_file() && entry.path().extension() == ".xml") {
+				files.push_back(entry.path().string());
+			}
+		}
+		//Directory order is unspecified, sorting keeps which file wins a name clash stable
+		std::sort(files.begin(), files.end());
+		load(files);
+	}
+
+	void XMLLibrary::loadManifest(const std::string& manifest) {
+		std::ifstream file(manifest);
+		if(!file) {
+			throw std::runtime_error("Cannot open " + manifest);
+		}
+		std::filesystem::path base = std::filesystem::path(manifest).parent_path();
+		std::vector<std::string> files;
+		std::string line;
+		while(std::getline(file, line)) {
+			line.erase(0, line.find_first_not_of(" \t\r"));
+			line.erase(line.find_last_not_of(" \t\r") + 1);
+			if(!line.empty() && line[0] != '#') {
+				files.push_back((base / line).string());
+			}
+		}
+		load(files);
+	}
+
+	XMLLibraryMemory XMLLibrary::getMemoryUsage() {
+		XMLLibraryMemory memory;
+		for(auto& tree : trees) {
+			std::size_t nodes = tree.second.getCapacity();
+			std::size_t bytes = tree.second.getMemoryUsage();
+			memory.layouts.push_back({tree.first, nodes, bytes});
+			memory.treeBytes += bytes;
+		}
+		std::sort(memory.layouts.begin(), memory.layouts.end(), [](const XMLLayoutMemory& a, const XMLLayoutMemory& b) {
+			return a.name < b.name;
+		});
+		memory.stringBytes = strings->getBytes();
+		memory.strings = strings->getCount();
+		memory.savedBytes = strings->getRequestedBytes() - strings->getStoredBytes();
+		memory.totalBytes = memory.treeBytes + memory.stringBytes;
+		return memory;
+	}
+
+}
+
+#endif /* DEARIMXML_XMLLIBRARY_H */
@@ -0,0 +1,199 @@
+#ifndef DEARIMXML_XMLPUSHPARSER_H
+#define DEARIMXML_XMLPUSHPARSER_H
+
+#include <XMLTree.h>
+#include <XMLReader.h>
+#include <ImGuiEnum.h>
+#include <memory>
+#include <stdexcept>
+#include <string>
+#include <string_view>
+#include <vector>
+
+namespace ImXML {
+
+	//Parser fed with chunks of a document as they arrive, e.g. from a socket. Elements are added to the
+	//tree as soon as their start tag is complete, so the tree can be rendered between feeds once it has
+	//a root. Only a tag cut by the end of a chunk is kept until the rest of it arrives.
+	class XMLPushParser
+	{
+	private:
+		XMLReader reader;
+		XMLTree tree;
+		std::unique_ptr<XMLStringCache> cache;
+		//Start of a tag or markup whose end has not arrived yet
+		std::string pending;
+		//Stream offset of the first byte not consumed, for error messages
+		std::size_t offset = 0;
+		std::vector<XMLNode*> open;
+		XMLEventCallback completed;
+		bool rootClosed = false;
+		bool failed = false;
+
+		//End of the tag or markup at i, npos while it is incomplete
+		static std::size_t tagLength(std::string_view xml, std::size_t i) {
+			std::string_view comment = "<!--";
+			if(xml.size() - i < comment.size() && xml.substr(i) == comment.substr(0, xml.size() - i)) {
+				return std::string_view::npos;
+			}
+			if(xml.compare(i, 4, comment) == 0) {
+				std::size_t end = xml.find("-->", i + 4);
+				return end == std::string_view::npos ? end : end + 3;
+			}
+			if(xml.compare(i, 2, "<?") == 0) {
+				std::size_t end = xml.find("?>", i + 2);
+				return end == std::string_view::npos ? end : end + 2;
+			}
+			for(std::size_t j = i + 1; j < xml.size(); j++) {
+				char c = xml[j];
+				if(c == '>') {
+					return j + 1;
+				}
+				if(c == '"' || c == '\'') {
+					j = xml.find(c, j + 1);
+					if(j == std::string_view::npos) {
+						break;
+					}
+				}
+			}
+			return std::string_view::npos;
+		}
+
+		void complete(XMLNode& node) {
+			if(open.empty()) {
+				rootClosed = true;
+			}
+			if(completed) {
+				completed(node);
+			}
+		}
+
+		//Parses every complete tag of xml, returns how many bytes were consumed
+		std::size_t consume(std::string_view xml) {
+			std::size_t i = 0;
+			while(true) {
+				i = XMLReader::skipSpace(xml, i);
+				if(i >= xml.size()) {
+					return i;
+				}
+				if(xml[i] != '<') {
+					XMLReader::fail("Unexpected text", offset + i);
+				}
+				std::size_t end = tagLength(xml, i);
+				if(end == std::string_view::npos) {
+					return i;
+				}
+				if(xml[i + 1] == '?' || xml[i + 1] == '!') {
+					i = end;
+					continue;
+				}
+				if(rootClosed) {
+					XMLReader::fail("Content after the root element", offset + i);
+				}
+				XMLReader::Tag tag;
+				XMLReader::ParsedNode parsed;
+				parsed.args = XMLAttributes(&tree.getAttributeStore());
+				std::size_t start = i;
+				i = reader.parseTag(xml.substr(0, end), i, tag, &parsed, cache.get());
+				ImGuiEnum type = XMLReader::tagType(tag.name, offset + start);
+				if(tag.closing) {
+					if(open.empty() || open.back()->type != type) {
+						XMLReader::fail("Unexpected closing tag " + std::string(tag.name), offset + start);
+					}
+					XMLNode& node = *open.back();
+					open.pop_back();
+					complete(node);
+					continue;
+				}
+				XMLNode& node = tree.createNode(type, open.empty() ? nullptr : open.back());
+				node.args = std::move(parsed.args);
+				node.flags = parsed.flags;
+				if(open.empty()) {
+					tree.setRoot(node);
+				}
+				tree.publish(node);
+				if(tag.selfClosing) {
+					complete(node);
+				} else {
+					open.push_back(&node);
+				}
+			}
+		}
+	public:
+		XMLPushParser();
+		~XMLPushParser();
+
+		XMLPushParser(const XMLPushParser&) = delete;
+		XMLPushParser& operator=(const XMLPushParser&) = delete;
+
+		//Called with each element once its end tag arrived, children before their parent
+		void setCompletedCallback(XMLEventCallback callback) {
+			completed = std::move(callback);
+		}
+
+		//Parses what the chunk completes, chunks may split a tag anywhere. Call between frames, the
+		//tree is mutated. After an error every later call throws.
+		void feed(const char* data, std::size_t length) {
+			if(failed) {
+				throw std::runtime_error("Push parser failed earlier");
+			}
+			try {
+				std::string_view xml(data, length);
+				if(!pending.empty()) {
+					pending.append(data, length);
+					xml = pending;
+				}
+				std::size_t consumed = consume(xml);
+				offset += consumed;
+				if(pending.empty()) {
+					pending.assign(xml.substr(consumed));
+				} else {
+					pending.erase(0, consumed);
+				}
+			} catch(...) {
+				failed = true;
+				throw;
+			}
+		}
+
+		//Checks that the whole document arrived, throws when it stopped inside an element
+		void finish() {
+			if(failed) {
+				throw std::runtime_error("Push parser failed earlier");
+			}
+			if(!pending.empty()) {
+				XMLReader::fail("Unterminated tag", offset);
+			}
+			if(!hasRoot()) {
+				throw std::runtime_error("Empty XML document");
+			}
+			if(!rootClosed) {
+				XMLReader::fail("Unclosed tag", offset);
+			}
+		}
+
+		//The tree can only be rendered once the root element arrived
+		bool hasRoot() const {
+			return tree.hasRoot();
+		}
+
+		bool isComplete() const {
+			return rootClosed;
+		}
+
+		XMLTree& getTree() {
+			return tree;
+		}
+	};
+
+	XMLPushParser::XMLPushParser() : cache(std::make_unique<XMLStringCache>(*tree.getStrings()))
+	{
+	}
+
+	XMLPushParser::~XMLPushParser()
+	{
+	}
+
+}
+
+#endif /* DEARIMXML_XMLPUSHPARSER_H */
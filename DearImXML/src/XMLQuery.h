@@ -0,0 +1,262 @@
+#ifndef DEARIMXML_XMLQUERY_H
+#define DEARIMXML_XMLQUERY_H
+
+#include <XMLTree.h>
+#include <ImGuiEnum.h>
+#include <algorithm>
+#include <cctype>
+#include <stdexcept>
+#include <string>
+#include <string_view>
+#include <vector>
+
+namespace ImXML {
+
+	//Selector compiled once into a list of matching steps, e.g. begin[name='Inspector'] > column sliderfloat.
+	//Supports tag names, *, #id, [attribute] and [attribute='value'] with descendant and > combinators.
+	class XMLSelector
+	{
+	private:
+		struct AttributeTest
+		{
+			std::string name;
+			std::string value;
+			bool anyValue;
+		};
+
+		struct Step
+		{
+			int type = -1;	//-1 matches any tag
+			std::string id;
+			std::vector<AttributeTest> attributes;
+			bool child = false;	//combinator to the previous step is > instead of descendant
+		};
+
+		std::vector<Step> steps;
+
+		static bool isNameChar(char c) {
+			return std::isalnum((unsigned char)c) || c == '_' || c == '-';
+		}
+
+		static std::string_view readName(std::string_view str, std::size_t& i) {
+			std::size_t start = i;
+			while(i < str.size() && isNameChar(str[i])) {
+				i++;
+			}
+			if(i == start) {
+				throw std::runtime_error("Expected a name in selector at " + std::to_string(start));
+			}
+			return str.substr(start, i - start);
+		}
+
+		bool matchStep(const Step& step, const XMLNode& node) const {
+			if(step.type >= 0 && node.type != step.type) {
+				return false;
+			}
+			if(!step.id.empty()) {
+				auto id = node.args.find("id");
+				if(id == node.args.end() || id->second != step.id) {
+					return false;
+				}
+			}
+			for(const AttributeTest& test : step.attributes) {
+				auto attribute = node.args.find(test.name);
+				if(attribute == node.args.end() || (!test.anyValue && attribute->second != test.value)) {
+					return false;
+				}
+			}
+			return true;
+		}
+
+		//Matches steps[0..step] right to left, walking up through the parents
+		bool matchFrom(std::size_t step, const XMLNode& node) const {
+			if(!matchStep(steps[step], node)) {
+				return false;
+			}
+			if(step == 0) {
+				return true;
+			}
+			if(steps[step].child) {
+				return node.parent != nullptr && matchFrom(step - 1, *node.parent);
+			}
+			for(const XMLNode* ancestor = node.parent; ancestor != nullptr; ancestor = ancestor->parent) {
+				if(matchFrom(step - 1, *ancestor)) {
+					return true;
+				}
+			}
+			return false;
+		}
+
+		void scan(XMLNode& node, std::vector<XMLNode*>& out) const {
+			if(matches(node)) {
+				out.push_back(&node);
+			}
+			for(auto child : node.children) {
+				scan(*child, out);
+			}
+		}
+
+		//Number of nodes the indexes give as candidates for a step, SIZE_MAX when it needs a scan
+		std::size_t candidateCount(const Step& step, XMLTree& tree) const {
+			if(!step.id.empty()) {
+				std::vector<XMLNode*> nodes;
+				tree.findAll(step.id, nodes);
+				return nodes.size();
+			}
+			return step.type >= 0 ? tree.findAll((ImGuiEnum)step.type).size() : SIZE_MAX;
+		}
+
+		void candidates(const Step& step, XMLTree& tree, std::vector<XMLNode*>& out) const {
+			if(!step.id.empty()) {
+				//Every node with the id, not only the one XMLTree::find returns
+				tree.findAll(step.id, out);
+			} else {
+				const auto& nodes = tree.findAll((ImGuiEnum)step.type);
+				out.insert(out.end(), nodes.begin(), nodes.end());
+			}
+		}
+
+		void scanBelow(XMLNode& node, std::vector<XMLNode*>& out) const {
+			for(auto child : node.children) {
+				if(matches(*child)) {
+					out.push_back(child);
+				}
+				scanBelow(*child, out);
+			}
+		}
+	public:
+		XMLSelector(std::string_view selector);
+		~XMLSelector();
+
+		bool matches(const XMLNode& node) const {
+			return matchFrom(steps.size() - 1, node);
+		}
+
+		//Starts from the step with the fewest candidates in the id and tag indexes. When that is the
+		//last step its candidates are checked directly, otherwise only the subtrees of the matching
+		//anchors are searched. Only selectors made of * steps scan the whole tree.
+		void run(XMLTree& tree, std::vector<XMLNode*>& out) const {
+			std::size_t anchor = steps.size() - 1;
+			std::size_t best = candidateCount(steps[anchor], tree);
+			for(std::size_t i = 0; i + 1 < steps.size(); i++) {
+				std::size_t count = candidateCount(steps[i], tree);
+				if(count < best) {
+					anchor = i;
+					best = count;
+				}
+			}
+			if(best == SIZE_MAX) {
+				if(tree.hasRoot()) {
+					scan(tree.getRoot(), out);
+				}
+				return;
+			}
+			std::vector<XMLNode*> anchors;
+			candidates(steps[anchor], tree, anchors);
+			std::size_t first = out.size();
+			for(XMLNode* node : anchors) {
+				if(!matchFrom(anchor, *node)) {
+					continue;
+				}
+				if(anchor == steps.size() - 1) {
+					out.push_back(node);
+				} else {
+					scanBelow(*node, out);
+				}
+			}
+			//Nested anchors find the same nodes more than once
+			if(anchor != steps.size() - 1) {
+				std::sort(out.begin() + first, out.end());
+				out.erase(std::unique(out.begin() + first, out.end()), out.end());
+			}
+		}
+	};
+
+	XMLSelector::XMLSelector(std::string_view selector)
+	{
+		std::size_t i = 0;
+		bool child = false;
+		while(i < selector.size()) {
+			char c = selector[i];
+			if(std::isspace((unsigned char)c)) {
+				i++;
+				continue;
+			}
+			if(c == '>') {
+				if(steps.empty() || child) {
+					throw std::runtime_error("Unexpected > in selector");
+				}
+				child = true;
+				i++;
+				continue;
+			}
+			Step step;
+			step.child = child;
+			child = false;
+			if(c == '*') {
+				i++;
+			} else if(isNameChar(c)) {
+				std::string name(readName(selector, i));
+				std::transform(name.begin(), name.end(), name.begin(), ::tolower);
+				auto type = tagnames.find(name);
+				if(type == tagnames.end()) {
+					throw std::runtime_error("Unknown tag " + name + " in selector");
+				}
+				step.type = type->second;
+			}
+			while(i < selector.size() && (selector[i] == '#' || selector[i] == '[')) {
+				if(selector[i] == '#') {
+					i++;
+					step.id = readName(selector, i);
+					continue;
+				}
+				i++;
+				AttributeTest test = {std::string(readName(selector, i)), "", true};
+				if(i < selector.size() && selector[i] == '=') {
+					i++;
+					test.anyValue = false;
+					if(i < selector.size() && (selector[i] == '\'' || selector[i] == '"')) {
+						char quote = selector[i++];
+						std::size_t end = selector.find(quote, i);
+						if(end == std::string_view::npos) {
+							throw std::runtime_error("Unterminated string in selector");
+						}
+						test.value = selector.substr(i, end - i);
+						i = end + 1;
+					} else {
+						test.value = readName(selector, i);
+					}
+				}
+				if(i >= selector.size() || selector[i] != ']') {
+					throw std::runtime_error("Expected ] in selector");
+				}
+				i++;
+				step.attributes.push_back(test);
+			}
+			if(i < selector.size() && !std::isspace((unsigned char)selector[i]) && selector[i] != '>') {
+				throw std::runtime_error(std::string("Unexpected ") + selector[i] + " in selector");
+			}
+			steps.push_back(step);
+		}
+		if(steps.empty() || child) {
+			throw std::runtime_error("Incomplete selector");
+		}
+	}
+
+	XMLSelector::~XMLSelector()
+	{
+	}
+
+	std::vector<XMLNode*> XMLTree::query(const XMLSelector& selector) {
+		std::vector<XMLNode*> result;
+		selector.run(*this, result);
+		return result;
+	}
+
+	std::vector<XMLNode*> XMLTree::query(std::string_view selector) {
+		return query(XMLSelector(selector));
+	}
+
+}
+
+#endif /* DEARIMXML_XMLQUERY_H */
@@ -2,129 +2,638 @@
 #define XMLREADER_H
 
 #include <string>
+#include <string_view>
 #include <XMLTree.h>
+#include <XMLCache.h>
+#include <XMLScan.h>
 #include <ImGuiEnum.h>
-#include <fstream>
-#include <iostream>
-#include <regex>
-#include <stack>
 #include <unordered_map>
 #include <ImGUI/imgui.h>
+#include <ImGUI/imgui_internal.h>	//ImGuiInputTextFlags_Multiline and NoMarkEdited
 #include <algorithm>
+#include <atomic>
+#include <cstring>
+#include <deque>
+#include <exception>
+#include <memory>
+#include <mutex>
+#include <thread>
+#include <vector>
 
 namespace ImXML {
+	class XMLAsyncRead;
+	class XMLPushParser;
+
+	struct XMLLoadStats
+	{
+		std::size_t nodes = 0;	//nodes created for the document
+		unsigned int sharedSubtrees = 0;	//repeated subtrees stored once as a template
+		unsigned int instances = 0;	//use nodes standing in for their copies
+		std::size_t savedNodes = 0;
+		std::size_t savedBytes = 0;	//node and attribute storage the copies would have taken
+	};
+
 	class XMLReader
 	{
 	private:
-		/* data */
-		static constexpr const char* ws = " \t\n\r\f\v";
-		static const std::unordered_map<std::string, ImGuiEnum> tagnames;
 		static const std::unordered_map<std::string, int> flagnames;
+		//Set by readAsync, checked between tags so a cancelled read stops early
+		const std::atomic<bool>* cancelled = nullptr;
+		unsigned int threads = 0;
+		//Pool for the strings of read trees, each tree gets its own when not set
+		std::shared_ptr<XMLStringPool> strings;
+		XMLLayoutCache* cache = nullptr;
+		bool lazy = false;
+		bool deduplicate = false;
+		XMLLoadStats stats;
+
+		//Documents below this size are parsed on the calling thread
+		static constexpr std::size_t parallelThreshold = 256 * 1024;
+
+		//Node parsed from a range of the document before it is stitched into the tree
+		struct ParsedNode
+		{
+			ImGuiEnum type;
+			XMLAttributes args;
+			int flags = 0;
+			int parent;	//index in the same range, -1 for top level elements of the range
+			uint32_t lazyBegin = 0;
+			uint32_t lazyEnd = 0;
+		};
+
+		struct Tag
+		{
+			std::string_view name;
+			bool closing = false;
+			bool selfClosing = false;
+		};
+
+		void checkCancelled() const {
+			if(cancelled != nullptr && *cancelled) {
+				throw std::runtime_error("Read cancelled");
+			}
+		}
+
+		static bool isSpace(char c) {
+			return c == ' ' || c == '\t' || c == '\n' || c == '\r' || c == '\f' || c == '\v';
+		}
 
-		// trim from end of string (right)
-		inline std::string& rtrim(std::string& s, const char* t = ws) {
-			s.erase(s.find_last_not_of(t) + 1);
-			return s;
+		static bool isNameChar(char c) {
+			return (c >= 'a' && c <= 'z') || (c >= 'A' && c <= 'Z') || (c >= '0' && c <= '9') || c == '_' || c == '-' || c == ':';
 		}
 
-		// trim from beginning of string (left)
-		inline std::string& ltrim(std::string& s, const char* t = ws) {
-			s.erase(0, s.find_first_not_of(t));
-			return s;
+		static std::size_t skipSpace(std::string_view xml, std::size_t i) {
+			while(i < xml.size() && isSpace(xml[i])) {
+				i++;
+			}
+			return i;
 		}
 
-		// trim from both ends of string (right then left)
-		inline std::string& trim(std::string& s, const char* t = ws) {
-			return ltrim(rtrim(s, t), t);
+		[[noreturn]] static void fail(const std::string& message, std::size_t offset) {
+			throw std::runtime_error(message + " at offset " + std::to_string(offset));
 		}
 
-		std::vector<std::string> tokenize(const std::string& line, const std::string& delimiters) {
-			std::vector<std::string> tokens;
-			int last = 0;
-			int i = 0;
-			for(char c : line) {
-				bool match = false;
-				for(char d : delimiters) {
-					if(c == d) {
-						match = true;
+		//Skips <?...?>, <!--...--> and <!...> at i, returns i when there is none
+		static std::size_t skipMarkup(std::string_view xml, std::size_t i) {
+			if(xml.compare(i, 2, "<?") == 0) {
+				std::size_t end = xml.find("?>", i + 2);
+				return end == std::string_view::npos ? fail("Unterminated processing instruction", i), 0 : end + 2;
+			}
+			if(xml.compare(i, 4, "<!--") == 0) {
+				std::size_t end = xml.find("-->", i + 4);
+				return end == std::string_view::npos ? fail("Unterminated comment", i), 0 : end + 3;
+			}
+			if(xml.compare(i, 2, "<!") == 0) {
+				std::size_t end = xml.find('>', i + 2);
+				return end == std::string_view::npos ? fail("Unterminated declaration", i), 0 : end + 1;
+			}
+			return i;
+		}
+
+		//End of the tag starting at i, skipping > inside quoted attribute values
+		static std::size_t tagEnd(std::string_view xml, std::size_t i) {
+			for(i++; i < xml.size(); i++) {
+				char c = xml[i];
+				if(c == '>') {
+					return i + 1;
+				}
+				if(c == '"' || c == '\'') {
+					i = xml.find(c, i + 1);
+					if(i == std::string_view::npos) {
 						break;
 					}
 				}
-				if(match) {
-					tokens.push_back(line.substr(last, i-last));
-					last = i+1;
+			}
+			fail("Unterminated tag", i);
+		}
+
+		//Offset of the tag closing the element whose content starts at begin, the content is not parsed
+		static std::size_t closingTag(std::string_view xml, std::size_t begin) {
+			int depth = 0;
+			std::size_t i = begin;
+			while(true) {
+				i = xml.find('<', i);
+				if(i == std::string_view::npos) {
+					fail("Unclosed tag", begin);
 				}
-				i++;
+				std::size_t markup = skipMarkup(xml, i);
+				if(markup != i) {
+					i = markup;
+					continue;
+				}
+				std::size_t end = tagEnd(xml, i);
+				if(xml[i + 1] == '/') {
+					if(depth == 0) {
+						return i;
+					}
+					depth--;
+				} else if(xml[end - 2] != '/') {
+					depth++;
+				}
+				i = end;
 			}
-			tokens.push_back(line.substr(last, i-last));
-			return tokens;
 		}
 
-		int parseFlags(std::string& flagstr) {
-			auto flags = tokenize(flagstr, "|,");
+		//Elements whose children a lazy read defers until they are first shown
+		static bool isDeferred(ImGuiEnum type) {
+			return type == ImGuiEnum::MENU || type == ImGuiEnum::TREENODE || type == ImGuiEnum::POPUPCONTEXTWINDOW;
+		}
+
+		static ImGuiEnum tagType(std::string_view name, std::size_t offset) {
+			std::string lower(name);
+			std::transform(lower.begin(), lower.end(), lower.begin(), ::tolower);
+			auto type = tagnames.find(lower);
+			if(type == tagnames.end()) {
+				fail("Unknown tag " + lower, offset);
+			}
+			return type->second;
+		}
+
+		int parseFlags(std::string_view flagstr, std::size_t offset) const {
 			int parsed = 0;
-			for(auto flag : flags) {
-				parsed |= flagnames.at(trim(flag));
+			while(!flagstr.empty()) {
+				std::size_t end = flagstr.find_first_of("|,");
+				std::string_view flag = flagstr.substr(0, end);
+				while(!flag.empty() && isSpace(flag.front())) {
+					flag.remove_prefix(1);
+				}
+				while(!flag.empty() && isSpace(flag.back())) {
+					flag.remove_suffix(1);
+				}
+				auto value = flagnames.find(std::string(flag));
+				if(value == flagnames.end()) {
+					fail("Unknown flag " + std::string(flag), offset);
+				}
+				parsed |= value->second;
+				flagstr = end == std::string_view::npos ? std::string_view() : flagstr.substr(end + 1);
 			}
 			return parsed;
 		}
 
-		XMLNode* stringToNode(std::string& str) {
-			std::regex tagname = std::regex(R"(<\/?\w+)");
-			std::smatch m;
-			std::regex_search(str, m, tagname);
-			auto prefix = m.str(0);
-			auto name = prefix.substr(1, prefix.length()-1);
-			XMLNode* node = new XMLNode;
-			std::transform(name.begin(), name.end(), name.begin(), ::tolower);
-			if(tagnames.find(name) == tagnames.end()) {
-				throw std::runtime_error("Unknown tag " + name);
+		//Parses the tag at i, storing the attributes in node when it opens an element. Returns the end of the tag.
+		std::size_t parseTag(std::string_view xml, std::size_t i, Tag& tag, ParsedNode* node, XMLStringCache* cache) const {
+			std::size_t start = i++;
+			if(i < xml.size() && xml[i] == '/') {
+				tag.closing = true;
+				i++;
 			}
-			node->type = tagnames.at(name);
-
-			std::regex arguments = std::regex(R"(\w+=\"[^"]+\")");
-			std::string::const_iterator searchStart(str.cbegin());
-
-			while(std::regex_search(searchStart, str.cend(), m, arguments)) {
-				for(auto x : m) {
-					auto argstr = x.str();
-					auto argtoken = tokenize(argstr, "=");
-					node->args.insert({argtoken[0], argtoken[1].substr(1, argtoken[1].length()-2)});
+			std::size_t name = i;
+			while(i < xml.size() && isNameChar(xml[i])) {
+				i++;
+			}
+			if(i == name) {
+				fail("Expected a tag name", start);
+			}
+			tag.name = xml.substr(name, i - name);
+			while(true) {
+				i = skipSpace(xml, i);
+				if(i >= xml.size()) {
+					fail("Unterminated tag", start);
+				}
+				if(xml[i] == '>') {
+					return i + 1;
+				}
+				if(xml.compare(i, 2, "/>") == 0 && !tag.closing) {
+					tag.selfClosing = true;
+					return i + 2;
+				}
+				if(tag.closing) {
+					fail("Unexpected character in closing tag", i);
+				}
+				std::size_t key = i;
+				while(i < xml.size() && isNameChar(xml[i])) {
+					i++;
+				}
+				if(i == key) {
+					fail("Expected an attribute name", i);
+				}
+				std::string_view keystr = xml.substr(key, i - key);
+				i = skipSpace(xml, i);
+				if(i >= xml.size() || xml[i] != '=') {
+					fail("Expected = after attribute " + std::string(keystr), i);
+				}
+				i = skipSpace(xml, i + 1);
+				if(i >= xml.size() || (xml[i] != '"' && xml[i] != '\'')) {
+					fail("Expected a quoted value for attribute " + std::string(keystr), i);
+				}
+				std::size_t end = xml.find(xml[i], i + 1);
+				if(end == std::string_view::npos) {
+					fail("Unterminated attribute value", i);
+				}
+				std::string_view value = xml.substr(i + 1, end - i - 1);
+				i = end + 1;
+				if(node != nullptr) {
+					node->args.emplace(cache->intern(keystr), cache->intern(value));
 					//Special case, flags must be converted
-					if(argtoken[0] == "flags") {
-						node->flags = parseFlags(node->args["flags"]);
+					if(keystr == "flags") {
+						node->flags = parseFlags(value, key);
 					}
 				}
-				searchStart = m.suffix().first;
 			}
-			return node;
 		}
 
-		XMLTree traverse(std::vector<std::string>& tags) {
-			std::stack<XMLNode*> parents;
-			XMLNode* lastparent = nullptr;
-			for(auto tagstr : tags) {
-				if(tagstr.at(1) == '/') {
-					lastparent = parents.top();
-					parents.pop();
+		//Parses the elements between begin and end into out, parents are indices into out. Attributes go to
+		//the store of the tree, or to one per range when ranges are parsed concurrently. With closed set the
+		//range ends at the first closing tag without an open element, whose offset is stored there.
+		void parseRange(std::string_view xml, std::size_t begin, std::size_t end, XMLAttributeStore& attributes, std::vector<ParsedNode>& out, std::size_t* closed = nullptr) const {
+			XMLStringCache cache(attributes.getPool());
+			std::vector<int> parents;
+			std::string_view range = xml.substr(0, end);
+			std::size_t i = begin;
+			while(true) {
+				i = skipSpace(range, i);
+				if(i >= end) {
+					break;
+				}
+				if(range[i] != '<') {
+					fail("Unexpected text", i);
+				}
+				std::size_t markup = skipMarkup(range, i);
+				if(markup != i) {
+					i = markup;
+					continue;
+				}
+				checkCancelled();
+				Tag tag;
+				ParsedNode node;
+				node.args = XMLAttributes(&attributes);
+				std::size_t start = i;
+				if(closed != nullptr && parents.empty() && range.compare(i, 2, "</") == 0) {
+					*closed = start;
+					return;
+				}
+				i = parseTag(range, i, tag, &node, &cache);
+				if(tag.closing) {
+					if(parents.empty() || out[parents.back()].type != tagType(tag.name, start)) {
+						fail("Unexpected closing tag " + std::string(tag.name), start);
+					}
+					parents.pop_back();
+					continue;
+				}
+				node.type = tagType(tag.name, start);
+				node.parent = parents.empty() ? -1 : parents.back();
+				if(!tag.selfClosing && lazy && isDeferred(node.type)) {
+					//Only the byte range of the children is kept, their closing tag is checked now
+					std::size_t close = closingTag(range, i);
+					if(skipSpace(range, i) < close) {
+						node.lazyBegin = i;
+						node.lazyEnd = close;
+					}
+					Tag closeTag;
+					i = parseTag(range, close, closeTag, nullptr, nullptr);
+					if(!closeTag.closing || tagType(closeTag.name, close) != node.type) {
+						fail("Unexpected closing tag " + std::string(closeTag.name), close);
+					}
+					tag.selfClosing = true;
+				}
+				out.push_back(std::move(node));
+				if(!tag.selfClosing) {
+					parents.push_back(out.size() - 1);
+				}
+			}
+			if(!parents.empty()) {
+				fail("Unclosed tag", begin);
+			}
+			if(closed != nullptr) {
+				fail("Unclosed root tag", begin);
+			}
+		}
+
+		//Structural pre-scan of the root content starting at begin. Appends the start of every top level
+		//element to starts and returns the offset of the closing root tag. Only the positions of <, >
+		//and quotes found by buildStructuralIndex are visited, text and names are never touched.
+		std::size_t splitTopLevel(std::string_view xml, std::size_t begin, std::vector<std::size_t>& starts) const {
+			if(xml.size() - begin > UINT32_MAX) {
+				fail("Document too large", begin);
+			}
+			std::vector<uint32_t> index;
+			buildStructuralIndex(xml.substr(begin), index);
+			int depth = 0;
+			std::size_t k = 0;
+			while(true) {
+				//Quotes and > outside of tags are text
+				while(k < index.size() && xml[begin + index[k]] != '<') {
+					k++;
+				}
+				if(k == index.size()) {
+					fail("Unclosed root tag", begin);
+				}
+				std::size_t i = begin + index[k];
+				std::size_t markup = skipMarkup(xml, i);
+				if(markup != i) {
+					while(k < index.size() && begin + index[k] < markup) {
+						k++;
+					}
+					continue;
+				}
+				//End of the tag, skipping > inside quoted attribute values
+				char quote = 0;
+				for(k++; k < index.size(); k++) {
+					char c = xml[begin + index[k]];
+					if(quote != 0) {
+						if(c == quote) {
+							quote = 0;
+						}
+					} else if(c == '"' || c == '\'') {
+						quote = c;
+					} else if(c == '>') {
+						break;
+					}
+				}
+				if(k == index.size()) {
+					fail("Unterminated tag", i);
+				}
+				std::size_t end = begin + index[k++] + 1;
+				if(xml[i + 1] == '/') {
+					if(depth == 0) {
+						return i;
+					}
+					depth--;
 				} else {
-					XMLNode* node = stringToNode(tagstr);
-					if(parents.size() > 0) {
-						parents.top()->children.push_back(node);
+					if(depth == 0) {
+						starts.push_back(i);
 					}
-					//not a inline tag
-					if(tagstr.at(tagstr.length()-2) != '/') {
-						parents.push(node);
+					if(xml[end - 2] != '/') {
+						depth++;
 					}
 				}
 			}
-			return XMLTree(*lastparent);
 		}
+
+		//Creates the nodes of a parsed range under parent, returns true when some of them are lazy
+		static bool attachParsed(XMLTree& tree, XMLNode& parent, std::vector<ParsedNode>& parsed, std::vector<XMLNode*>& nodes) {
+			bool deferred = false;
+			nodes.resize(parsed.size());
+			for(std::size_t n = 0; n < parsed.size(); n++) {
+				ParsedNode& source = parsed[n];
+				XMLNode& node = tree.createNode(source.type, source.parent < 0 ? &parent : nodes[source.parent]);
+				node.args = std::move(source.args);
+				node.flags = source.flags;
+				node.lazyBegin = source.lazyBegin;
+				node.lazyEnd = source.lazyEnd;
+				deferred |= XMLTree::isLazy(node);
+				nodes[n] = &node;
+			}
+			return deferred;
+		}
+
+		//Subtrees of the flattened document that can be shared: no ids, which must stay unique, no $ values,
+		//which instances would substitute, no lazy ranges and no templates
+		static bool isShareable(const ParsedNode& node) {
+			if(node.type == ImGuiEnum::TEMPLATE || node.type == ImGuiEnum::USE || node.lazyEnd > node.lazyBegin) {
+				return false;
+			}
+			for(const XMLAttribute& arg : node.args) {
+				if(arg.first == "id" || (!arg.second.empty() && arg.second.c_str()[0] == '$')) {
+					return false;
+				}
+			}
+			return true;
+		}
+
+		//Containers rendering their children themselves rather than traversing them. A use in their place
+		//draws only the entries the container renders, so their children are never shared.
+		static bool rendersChildren(ImGuiEnum type) {
+			return type == ImGuiEnum::MENUBAR || type == ImGuiEnum::MENU || type == ImGuiEnum::TREE || type == ImGuiEnum::TREENODE;
+		}
+
+		static uint64_t mix(uint64_t hash, uint64_t value) {
+			hash = (hash ^ value) * 0x9e3779b97f4a7c15ull;
+			return hash ^ (hash >> 29);
+		}
+
+		//Creates the nodes of the whole document under root, each subtree repeated often enough to pay for
+		//a template is stored once under root and its copies become uses of it. Subtrees are contiguous in
+		//document order, so two are equal when their nodes are equal one by one, strings compare by address
+		//as they are interned. Returns true when some nodes are lazy.
+		bool attachShared(XMLTree& tree, XMLNode& root, std::vector<ParsedNode>& all) {
+			std::size_t count = all.size();
+			std::vector<uint32_t> size(count, 1);
+			std::vector<char> shareable(count);
+			for(std::size_t n = count; n-- > 0;) {
+				shareable[n] |= isShareable(all[n]) ? 1 : 2;
+				if(all[n].parent >= 0) {
+					size[all[n].parent] += size[n];
+					shareable[all[n].parent] |= shareable[n] & 2;
+				}
+			}
+			for(std::size_t n = 0; n < count; n++) {
+				int parent = all[n].parent;
+				if(parent >= 0 && (all[parent].type == ImGuiEnum::TEMPLATE || shareable[parent] & 4)) {
+					shareable[n] |= 4;	//inside a template
+				}
+				if(rendersChildren(parent >= 0 ? all[parent].type : root.type)) {
+					shareable[n] |= 8;
+				}
+			}
+			auto candidate = [&](std::size_t n) {
+				return shareable[n] == 1 && size[n] > 1;
+			};
+			std::vector<uint64_t> hash(count);
+			std::unordered_map<uint64_t, unsigned int> occurrences;
+			for(std::size_t n = 0; n < count; n++) {
+				if(!candidate(n)) {
+					continue;
+				}
+				uint64_t h = size[n];
+				for(std::size_t k = n; k < n + size[n]; k++) {
+					const ParsedNode& node = all[k];
+					h = mix(h, ((uint64_t)node.type << 32) ^ (uint32_t)node.flags);
+					h = mix(h, k == n ? 0 : k - node.parent);
+					for(const XMLAttribute& arg : node.args) {
+						h = mix(h, (uintptr_t)arg.first.data);
+						h = mix(h, (uintptr_t)arg.second.data);
+					}
+				}
+				hash[n] = h;
+				occurrences[h]++;
+			}
+			auto same = [&](std::size_t a, std::size_t b) {
+				for(std::size_t k = 0; k < size[a]; k++) {
+					const ParsedNode& x = all[a + k];
+					const ParsedNode& y = all[b + k];
+					if(x.type != y.type || x.flags != y.flags || x.args.size() != y.args.size() || (k > 0 && a + k - x.parent != b + k - y.parent)) {
+						return false;
+					}
+					for(auto p = x.args.begin(), q = y.args.begin(); p != x.args.end(); ++p, ++q) {
+						if(p->first != q->first || p->second != q->second) {
+							return false;
+						}
+					}
+				}
+				return true;
+			};
+
+			//Outermost repeated subtrees first, the ones nested in them are shared along with them
+			std::unordered_map<uint64_t, std::vector<std::size_t>> groups;
+			for(std::size_t n = 0; n < count;) {
+				if(candidate(n) && occurrences[hash[n]] > 1) {
+					std::vector<std::size_t>& copies = groups[hash[n]];
+					if(copies.empty() || same(copies.front(), n)) {
+						copies.push_back(n);
+						n += size[n];
+						continue;
+					}
+				}
+				n++;
+			}
+			//A template costs its own node and a use per copy
+			std::vector<int> group(count, -1);
+			std::vector<std::size_t> shared;
+			for(auto& entry : groups) {
+				std::vector<std::size_t>& copies = entry.second;
+				std::size_t nodes = size[copies.front()];
+				if(copies.size() * nodes <= 1 + nodes + copies.size()) {
+					continue;
+				}
+				for(std::size_t copy : copies) {
+					group[copy] = shared.size();
+				}
+				shared.push_back(copies.front());
+				std::size_t bytes = 0;
+				for(std::size_t k = copies.front(); k < copies.front() + nodes; k++) {
+					bytes += sizeof(XMLNode) + sizeof(XMLNode*) + all[k].args.size() * XMLAttributes::itemSize;
+				}
+				std::size_t overhead = sizeof(XMLNode) + sizeof(XMLNode*) + XMLAttributes::itemSize;
+				stats.sharedSubtrees++;
+				stats.instances += copies.size();
+				stats.savedNodes += (copies.size() - 1) * nodes - copies.size() - 1;
+				if((copies.size() - 1) * bytes > (copies.size() + 1) * overhead) {
+					stats.savedBytes += (copies.size() - 1) * bytes - (copies.size() + 1) * overhead;
+				}
+			}
+
+			bool deferred = false;
+			std::vector<XMLNode*> nodes(count);
+			for(std::size_t n = 0; n < count;) {
+				ParsedNode& source = all[n];
+				XMLNode& parent = source.parent < 0 ? root : *nodes[source.parent];
+				if(group[n] >= 0) {
+					XMLNode& use = tree.createNode(ImGuiEnum::USE, &parent);
+					use.args.emplace("template", "#" + std::to_string(group[n]));
+					nodes[n] = &use;
+					if(shared[group[n]] != n) {
+						//Later copies are dropped, their attribute ranges go back to the store
+						for(std::size_t k = n; k < n + size[n]; k++) {
+							all[k].args = XMLAttributes();
+						}
+					}
+					n += size[n];
+					continue;
+				}
+				XMLNode& node = tree.createNode(source.type, &parent);
+				node.args = std::move(source.args);
+				node.flags = source.flags;
+				node.lazyBegin = source.lazyBegin;
+				node.lazyEnd = source.lazyEnd;
+				deferred |= XMLTree::isLazy(node);
+				nodes[n] = &node;
+				n++;
+			}
+			//The first copy of each subtree was replaced by a use, its nodes become the template
+			for(std::size_t g = 0; g < shared.size(); g++) {
+				XMLNode& shape = tree.createNode(ImGuiEnum::TEMPLATE, &root);
+				shape.args.emplace("name", "#" + std::to_string(g));
+				//Copies keep the ImGui ids they have in the plain tree
+				shape.args.emplace("seed", "false");
+				std::size_t first = shared[g];
+				for(std::size_t k = first; k < first + size[first]; k++) {
+					ParsedNode& source = all[k];
+					XMLNode& node = tree.createNode(source.type, k == first ? &shape : nodes[source.parent]);
+					node.args = std::move(source.args);
+					node.flags = source.flags;
+					nodes[k] = &node;
+				}
+			}
+			return deferred;
+		}
+
+		//Reader with the same settings for another thread or a later parse, without statistics,
+		//cancellation or, when the copy may outlive it, the cache
+		XMLReader configured(bool keepCache) const {
+			XMLReader reader;
+			reader.threads = threads;
+			reader.strings = strings;
+			reader.cache = keepCache ? cache : nullptr;
+			reader.lazy = lazy;
+			reader.deduplicate = deduplicate;
+			return reader;
+		}
+
+		//XMLLazySource::parse of lazily read trees, reader is a copy of the one that deferred the ranges
+		static void parseDeferred(const XMLReader& reader, XMLTree& tree, XMLNode& node, std::string_view xml, std::size_t begin, std::size_t end) {
+			std::vector<ParsedNode> parsed;
+			std::vector<XMLNode*> nodes;
+			reader.parseRange(xml, begin, end, tree.getAttributeStore(), parsed);
+			attachParsed(tree, node, parsed, nodes);
+		}
+
+		XMLTree parse(std::string_view xml);
+		friend class XMLAsyncRead;
+		friend class XMLPushParser;
+		friend class XMLHotReload;
 	public:
 		XMLReader();
 		~XMLReader();
 
 		XMLTree read(std::string filename);
+		//Parses a document already in memory, e.g. one embedded with imxml_embed_layouts (see XMLEmbed.h)
+		XMLTree readBuffer(std::string_view xml);
+		//Parses on a worker thread with the settings of this reader, see XMLAsyncRead
+		XMLAsyncRead readAsync(const std::string& filename);
+
+		//Trees read afterwards intern their strings into pool, which may be shared by several readers
+		void setStringPool(std::shared_ptr<XMLStringPool> pool) {
+			strings = std::move(pool);
+		}
+
+		//Parse results of read are looked up in and stored to cache, nullptr disables caching
+		void setCache(XMLLayoutCache* layoutCache) {
+			cache = layoutCache;
+		}
+
+		//Children of menu, treenode and popupcontextwindow elements are kept as text and parsed the first
+		//time they are shown, see XMLTree::materialize. Lazy reads bypass the parse cache.
+		void setLazy(bool deferChildren) {
+			lazy = deferChildren;
+		}
+
+		//Repeated subtrees without ids are stored once and rendered through <use> elements of a generated
+		//<template seed="false">, which renders like the copies did, ImGui ids included. Children of menus
+		//and trees are never shared. Editing a shared subtree edits every copy. Deduplicated trees are cached apart from plain ones.
+		void setDeduplicate(bool shareSubtrees) {
+			deduplicate = shareSubtrees;
+		}
+
+		//Statistics of the last document parsed, a cache hit does not parse
+		const XMLLoadStats& getLoadStats() const {
+			return stats;
+		}
+
+		//Threads used for large documents, 0 uses every core and 1 parses on the calling thread
+		void setThreads(unsigned int count) {
+			threads = count;
+		}
 	};
 	
 	XMLReader::XMLReader()
@@ -135,56 +644,301 @@ namespace ImXML {
 	{
 	}
 
-	XMLTree XMLReader::read(std::string filename) {
-		std::ifstream file(filename);
-		std::string str;
-		std::vector<std::string> taglines;
-		while (std::getline(file, str))
-		{
-			std::string trimmed = trim(str);
-			if(trimmed.length() <= 0) {
-				continue;
+	//Single pass over the document buffer. Large documents are pre-scanned for the boundaries of the
+	//elements below the root, which are parsed concurrently and stitched into the tree in document order.
+	XMLTree XMLReader::parse(std::string_view xml) {
+		std::size_t i = 0;
+		while(true) {
+			i = skipSpace(xml, i);
+			if(i >= xml.size()) {
+				throw std::runtime_error("Empty XML document");
+			}
+			if(xml[i] != '<') {
+				fail("Unexpected text", i);
+			}
+			std::size_t markup = skipMarkup(xml, i);
+			if(markup == i) {
+				break;
+			}
+			i = markup;
+		}
+
+		stats = XMLLoadStats();
+		XMLTree tree = strings != nullptr ? XMLTree(strings) : XMLTree();
+		XMLStringPool& pool = *tree.getStrings();
+		Tag rootTag;
+		ParsedNode rootNode;
+		rootNode.args = XMLAttributes(&tree.getAttributeStore());
+		std::size_t rootStart = i;
+		XMLStringCache cache(pool);
+		i = parseTag(xml, i, rootTag, &rootNode, &cache);
+		if(rootTag.closing) {
+			fail("Unexpected closing tag " + std::string(rootTag.name), rootStart);
+		}
+		XMLNode& root = tree.createNode(tagType(rootTag.name, rootStart));
+		root.args = std::move(rootNode.args);
+		root.flags = rootNode.flags;
+		tree.setRoot(root);
+
+		if(!rootTag.selfClosing) {
+			//Ranges of consecutive top level elements, several per thread so uneven elements balance out.
+			//A document parsed as one range finds the closing root tag as it goes and is not pre-scanned.
+			unsigned int count = threads > 0 ? threads : std::max(1u, std::thread::hardware_concurrency());
+			std::vector<std::size_t> bounds = {i};
+			std::size_t close = std::string_view::npos;
+			if(xml.size() - i > UINT32_MAX) {
+				fail("Document too large", i);
+			}
+			if(count > 1 && xml.size() - i >= parallelThreshold) {
+				std::vector<std::size_t> starts;
+				close = splitTopLevel(xml, i, starts);
+				starts.push_back(close);
+				if(close - i >= parallelThreshold) {
+					std::size_t target = (close - i) / (count * 4) + 1;
+					for(std::size_t start : starts) {
+						if(start - bounds.back() >= target) {
+							bounds.push_back(start);
+						}
+					}
+				}
+				if(bounds.back() != close) {
+					bounds.push_back(close);
+				}
+			} else {
+				bounds.push_back(xml.size());
+			}
+			std::size_t* closed = close == std::string_view::npos ? &close : nullptr;
+
+			std::size_t ranges = bounds.size() - 1;
+			//A single range adds its attributes to the tree directly, concurrent ranges each have a store
+			//and are copied into the tree as they are attached
+			std::deque<XMLAttributeStore> stores;
+			for(std::size_t range = 0; ranges > 1 && range < ranges; range++) {
+				stores.emplace_back(&pool);
+			}
+			std::vector<std::vector<ParsedNode>> parsed(ranges);
+			std::vector<std::exception_ptr> errors(ranges);
+			auto work = [&](std::size_t range) {
+				try {
+					XMLAttributeStore& attributes = ranges > 1 ? stores[range] : tree.getAttributeStore();
+					parseRange(xml, bounds[range], bounds[range + 1], attributes, parsed[range], closed);
+				} catch(...) {
+					errors[range] = std::current_exception();
+				}
+			};
+			if(ranges == 1) {
+				work(0);
+			} else {
+				std::atomic<std::size_t> next{0};
+				std::vector<std::thread> pool;
+				for(unsigned int t = 0; t < std::min<std::size_t>(count, ranges); t++) {
+					pool.emplace_back([&]() {
+						for(std::size_t range; (range = next++) < ranges;) {
+							work(range);
+						}
+					});
+				}
+				for(auto& thread : pool) {
+					thread.join();
+				}
 			}
-			if(trimmed.at(0) != '<') {
-				throw std::runtime_error("Invalid XML line");
+
+			for(std::size_t range = 0; range < ranges; range++) {
+				if(errors[range]) {
+					std::rethrow_exception(errors[range]);
+				}
+			}
+			Tag closeTag;
+			std::size_t after = parseTag(xml, close, closeTag, nullptr, nullptr);
+			if(tagType(closeTag.name, close) != root.type) {
+				fail("Unexpected closing tag " + std::string(closeTag.name), close);
 			}
 
-			std::regex tagregex = std::regex(R"(^<\s*[^\?][ -~]+\/?>)");
-			std::smatch m;
-			if(std::regex_search(trimmed, m, tagregex)) {
-				taglines.push_back(m.str(0));
+			std::vector<XMLNode*> nodes;
+			bool deferred = false;
+			for(std::size_t range = 0; range < ranges; range++) {
+				if(!deduplicate) {
+					deferred |= attachParsed(tree, root, parsed[range], nodes);
+				}
+			}
+			if(deduplicate) {
+				//Repeated subtrees may span ranges, they are found in the whole document
+				std::vector<ParsedNode> all;
+				for(auto& range : parsed) {
+					int base = all.size();
+					for(ParsedNode& node : range) {
+						if(node.parent >= 0) {
+							node.parent += base;
+						}
+						all.push_back(std::move(node));
+					}
+					range = std::vector<ParsedNode>();
+				}
+				deferred = attachShared(tree, root, all);
 			}
+			//Deferred children are parsed from a copy, the buffer being read may not outlive the tree
+			if(deferred) {
+				auto source = std::make_shared<XMLLazySource>();
+				source->xml.assign(xml.data(), xml.size());
+				source->parse = [reader = configured(false)](XMLTree& tree, XMLNode& node, std::string_view xml, std::size_t begin, std::size_t end) {
+					parseDeferred(reader, tree, node, xml, begin, end);
+				};
+				tree.setLazySource(std::move(source));
+			}
+			i = after;
+		}
+
+		while(true) {
+			i = skipSpace(xml, i);
+			if(i >= xml.size()) {
+				break;
+			}
+			std::size_t markup = xml[i] == '<' ? skipMarkup(xml, i) : i;
+			if(markup == i) {
+				fail("Content after the root element", i);
+			}
+			i = markup;
+		}
+		tree.reindex();
+		stats.nodes = tree.getCapacity();
+		return tree;
+	}
 
+	XMLTree XMLReader::read(std::string filename) {
+		XMLMappedFile file(filename);
+		if(!file.isOpen()) {
+			throw std::runtime_error("Cannot open " + filename);
 		}
+		return readBuffer(file.view());
+	}
 
-		return traverse(taglines);
+	XMLTree XMLReader::readBuffer(std::string_view xml) {
+		if(cache == nullptr || lazy) {
+			return parse(xml);
+		}
+		uint64_t key = XMLLayoutCache::key(xml);
+		if(deduplicate) {
+			key = ~key;
+		}
+		XMLTree tree = strings != nullptr ? XMLTree(strings) : XMLTree();
+		if(!cache->load(key, tree)) {
+			tree = parse(xml);
+			cache->store(key, tree);
+		}
+		return tree;
 	}
 
-	const std::unordered_map<std::string, ImGuiEnum> XMLReader::tagnames = {
-		{ "begin", ImGuiEnum::BEGIN },
-		{ "button" , ImGuiEnum::BUTTON },
-		{ "placeholder", ImGuiEnum::PLACEHOLDER },
-		{ "text", ImGuiEnum::TEXT },
-		{ "sameline", ImGuiEnum::SAMELINE },
-		{ "menubar", ImGuiEnum::MENUBAR },
-		{ "menu", ImGuiEnum::MENU },
-		{ "menuitem", ImGuiEnum::MENUITEM },
-		{ "sliderfloat", ImGuiEnum::SLIDERFLOAT },
-		{ "inputtext", ImGuiEnum::INPUTTEXT },
-		{ "treenode", ImGuiEnum::TREENODE },
-		{ "tree", ImGuiEnum::TREE },
-		{ "columns", ImGuiEnum::COLUMNS },
-		{ "column", ImGuiEnum::COLUMN },
-		{ "group", ImGuiEnum::GROUP },
-		{ "colorpicker3", ImGuiEnum::COLORPICKER3 },
-		{ "colorpicker4", ImGuiEnum::COLORPICKER4 },
-		{ "coloredit3", ImGuiEnum::COLOREDIT3 },
-		{ "coloredit4", ImGuiEnum::COLOREDIT4 },
-		{ "popupcontextwindow", ImGuiEnum::POPUPCONTEXTWINDOW },
-		{ "separator", ImGuiEnum::SEPARATOR },
+	//Layout parsed on a worker thread. getTree() holds a placeholder window until update() swaps in
+	//the parsed tree, which the renderer does at the start of the frame after the parse finished.
+	class XMLAsyncRead
+	{
+	private:
+		enum Status { Loading, Ready, Failed, ErrorShown, Swapped };
+
+		//Shared with the worker, heap allocated so the handle can be moved while it runs
+		struct State
+		{
+			std::mutex mutex;
+			std::atomic<bool> cancelled{false};
+			Status status = Loading;
+			XMLTree parsed;
+			std::string error;
+		};
 
+		XMLTree tree;
+		std::unique_ptr<State> state;
+		std::thread worker;
+
+		static XMLTree placeholder(const std::string& name, const std::string& label) {
+			XMLTree tree;
+			XMLNode& root = tree.createNode(ImGuiEnum::BEGIN);
+			root.args.set("name", name);
+			XMLNode& text = tree.createNode(ImGuiEnum::TEXT, &root);
+			text.args.set("label", label);
+			tree.setRoot(root);
+			tree.reindex();
+			return tree;
+		}
+	public:
+		//The worker reads with a copy of the settings of reader, a shared cache or string pool must outlive the read
+		XMLAsyncRead(const std::string& filename, const XMLReader& reader = XMLReader());
+		~XMLAsyncRead();
+
+		XMLAsyncRead(XMLAsyncRead&&) = default;
+		XMLAsyncRead& operator=(XMLAsyncRead&&) = delete;
+
+		//Swaps in the parsed tree once it is ready, returns true on the call that did.
+		//Only call between frames, node pointers into the placeholder become invalid.
+		bool update() {
+			std::lock_guard<std::mutex> lock(state->mutex);
+			if(state->status == Ready) {
+				tree = std::move(state->parsed);
+				state->status = Swapped;
+				return true;
+			}
+			if(state->status == Failed) {
+				tree = placeholder("Error", state->error);
+				state->status = ErrorShown;
+			}
+			return false;
+		}
+
+		//The placeholder until update() swapped in the parsed tree
+		XMLTree& getTree() {
+			return tree;
+		}
+
+		bool isLoaded() {
+			std::lock_guard<std::mutex> lock(state->mutex);
+			return state->status == Swapped;
+		}
+
+		//Message of a failed read, empty while loading or after success
+		std::string getError() {
+			std::lock_guard<std::mutex> lock(state->mutex);
+			return state->error;
+		}
+
+		//Stops the parse at the next line or tag, the placeholder is kept
+		void cancel() {
+			state->cancelled = true;
+		}
 	};
 
+	XMLAsyncRead::XMLAsyncRead(const std::string& filename, const XMLReader& settings) : tree(placeholder(filename, "Loading " + filename + "...")), state(std::make_unique<State>())
+	{
+		worker = std::thread([filename, reader = settings.configured(true), state = state.get()]() mutable {
+			reader.cancelled = &state->cancelled;
+			try {
+				XMLTree parsed = reader.read(filename);
+				std::lock_guard<std::mutex> lock(state->mutex);
+				if(!state->cancelled) {
+					state->parsed = std::move(parsed);
+					state->status = Ready;
+				}
+			} catch(const std::exception& e) {
+				std::lock_guard<std::mutex> lock(state->mutex);
+				if(!state->cancelled) {
+					state->error = e.what();
+					state->status = Failed;
+				}
+			}
+		});
+	}
+
+	XMLAsyncRead::~XMLAsyncRead()
+	{
+		//A moved from handle has no worker left
+		if(worker.joinable()) {
+			state->cancelled = true;
+			worker.join();
+		}
+	}
+
+	XMLAsyncRead XMLReader::readAsync(const std::string& filename) {
+		return XMLAsyncRead(filename, *this);
+	}
+
 	const std::unordered_map<std::string, int> XMLReader::flagnames = {
 		//Window flags
 		{ "ImGuiWindowFlags_None", ImGuiWindowFlags_None },
@@ -2,40 +2,546 @@
 #define XMLRENDERER_H
 
 #include <XMLTree.h>
+#include <XMLReader.h>
 #include <XMLEventHandler.h>
 #include <XMLDynamicBind.h>
+#include <XMLSchema.h>
 #include <ImGUI/imgui.h>
+#include <ImGUI/imgui_stdlib.h>
+#include <algorithm>
 #include <unordered_map>
+#include <stdexcept>
+#include <cstdlib>
+#include <cstring>
+#include <functional>
 
 namespace ImXML {
-	class XMLRenderer
+
+	//Link generations are shared by every renderer so a tree never mistakes another renderer's links for its own
+	inline unsigned int nextLinkGeneration() {
+		static unsigned int generation = 0;
+		return ++generation;
+	}
+
+	//Handler is called directly, XMLEventHandler keeps virtual dispatch while a concrete or
+	//XMLStaticEventHandler based type lets the compiler inline its hooks and drop empty ones
+	template<typename Handler = XMLEventHandler>
+	class BasicXMLRenderer
 	{
 	private:
 		int sameline = 0;
 		bool popup = false;
 		std::unordered_map<std::string, XMLDynamicBind> dynamicBinds;
+		std::unordered_map<std::string, XMLStructBind> structBinds;
+		//Binds resolved from struct paths, kept here so tree slots can point at them
+		std::unordered_map<std::string, XMLDynamicBind> resolvedPaths;
+		std::unordered_map<std::string, XMLBindCallbacks> bindCallbacks;
+		std::unordered_map<std::string, XMLEventCallback> idRoutes;
+		std::unordered_map<ImGuiEnum, XMLEventCallback> tagRoutes;
+		std::unordered_map<std::string, XMLMount> mounts;
+		std::unordered_map<std::string, XMLUserData> userData;
+		XMLEventCallback observer;
+		std::vector<XMLDynamicBind*>* binds = nullptr;
+		std::vector<XMLEventCallback*>* routes = nullptr;
+		std::vector<XMLMount*>* treeMounts = nullptr;
+		std::vector<XMLNode*>* treeTemplates = nullptr;
+		XMLTree* tree = nullptr;
+		//<use> node whose template is being rendered and the first of its bind slots
+		const XMLNode* instance = nullptr;
+		int slotOffset = 0;
+		//Value pointers of the bind scope being rendered, nullptr renders the values bound to the renderer
+		void* const* scope = nullptr;
+		std::size_t scopeSize = 0;
+		//Set when a template or use changed, their slots are only laid out by a full link
+		bool relinkAll = false;
+		unsigned int bindGeneration = nextLinkGeneration();
+
+		//Trees linked before are relinked on their next render, resolved paths are recomputed then
+		void invalidateLinks() {
+			resolvedPaths.clear();
+			bindGeneration = nextLinkGeneration();
+		}
+
+		//Which bind types a widget can be linked against
+		static bool acceptsBind(ImGuiEnum widget, XMLDynamicBindType type) {
+			switch(widget) {
+				case ImGuiEnum::SLIDERFLOAT:
+				case ImGuiEnum::INPUTFLOAT:
+					return type == Float;
+				case ImGuiEnum::SLIDERINT:
+				case ImGuiEnum::INPUTINT:
+					return type == Int;
+				case ImGuiEnum::INPUTDOUBLE:
+					return type == Double;
+				case ImGuiEnum::CHECKBOX:
+					return type == Bool;
+				case ImGuiEnum::INPUTTEXT:
+					return type == Chars || type == String;
+				case ImGuiEnum::COLORPICKER3:
+				case ImGuiEnum::COLOREDIT3:
+					return type == Float3;
+				case ImGuiEnum::COLORPICKER4:
+				case ImGuiEnum::COLOREDIT4:
+					return type == Float4;
+				case ImGuiEnum::RADIOBUTTON:
+					return type == Int || type == Enum;
+				default:
+					return false;
+			}
+		}
+
+		XMLDynamicBind& findBind(const std::string& name) {
+			XMLDynamicBind* bind = nullptr;
+			auto named = dynamicBinds.find(name);
+			auto resolved = resolvedPaths.find(name);
+			if(named != dynamicBinds.end()) {
+				bind = &named->second;
+			} else if(resolved != resolvedPaths.end()) {
+				bind = &resolved->second;
+			} else {
+				//Path into a registered struct, e.g. robot.arm.angle or robot.joints[2]
+				std::size_t split = name.find_first_of(".[");
+				if(split != std::string::npos) {
+					auto root = structBinds.find(name.substr(0, split));
+					XMLDynamicBind path;
+					if(root != structBinds.end() && root->second.resolve(root->second.ptr, std::string_view(name).substr(split), path)) {
+						bind = &resolvedPaths.insert({name, path}).first->second;
+					}
+				}
+			}
+			if(bind == nullptr) {
+				throw std::runtime_error("Unknown dynamic bind " + name);
+			}
+			auto callbacks = bindCallbacks.find(name);
+			bind->callbacks = callbacks != bindCallbacks.end() ? &callbacks->second : nullptr;
+			if(bind->callbacks != nullptr && bind->callbacks->onEvent && (bind->callbacks->eventType != bind->type || bind->callbacks->eventSize != bind->size)) {
+				throw std::runtime_error("Change event for " + name + " does not match the type " + bindTypeName(bind->type) + " of its bind");
+			}
+			return *bind;
+		}
+
+		XMLEventCallback* findRoute(XMLNode& node) {
+			auto id = node.args.find("id");
+			if(id != node.args.end()) {
+				auto route = idRoutes.find(id->second.str());
+				if(route != idRoutes.end()) {
+					return &route->second;
+				}
+			}
+			auto route = tagRoutes.find(node.type);
+			return route != tagRoutes.end() ? &route->second : nullptr;
+		}
+
+		//Value of a template attribute for an instance, $name values are replaced by the parameter name of the use
+		static XMLString substitute(XMLString value, const XMLNode* use) {
+			if(use != nullptr && value.size() > 1 && value.c_str()[0] == '$') {
+				return use->args[std::string_view(value).substr(1)];
+			}
+			return value;
+		}
+
+		XMLString arg(const XMLNode& node, std::string_view key) const {
+			return substitute(node.args[key], instance);
+		}
+
+		XMLDynamicBind* slot(const XMLNode& node) {
+			return (*binds)[slotOffset + node.bindSlot];
+		}
+
+		//Bound value of the node, from the scope of this render when there is one
+		void* valueOf(const XMLNode& node) {
+			int index = slotOffset + node.bindSlot;
+			//Slots of children materialized during the render are not in the scope
+			return scope != nullptr && (std::size_t)index < scopeSize ? scope[index] : (*binds)[index]->ptr;
+		}
+
+		//Throws when rendering subtree would render tree again through the tree mounts of this renderer
+		void checkMount(const XMLTree& subtree, const XMLTree& tree, std::vector<const XMLTree*>& visited) {
+			if(&subtree == &tree) {
+				throw std::runtime_error("Mounted tree contains the tree it is mounted in");
+			}
+			if(std::find(visited.begin(), visited.end(), &subtree) != visited.end()) {
+				return;
+			}
+			visited.push_back(&subtree);
+			for(const XMLNode* node : subtree.findAll(ImGuiEnum::PLACEHOLDER)) {
+				auto id = node->args.find("id");
+				auto mount = id != node->args.end() ? mounts.find(id->second.str()) : mounts.end();
+				if(mount != mounts.end() && mount->second.tree != nullptr) {
+					checkMount(*mount->second.tree, tree, visited);
+				}
+			}
+		}
+
+		//Fonts are checked when the tree is linked, a font removed from the atlas afterwards renders with the default one
+		static void checkFont(std::string_view name) {
+			if(findFont(name) == nullptr) {
+				throw std::runtime_error("Unknown font " + std::string(name));
+			}
+		}
+
+		//Resolves the route, user data and mount of a single node
+		void linkCommon(XMLNode& node, XMLTree& tree) {
+			std::vector<XMLEventCallback*>& nodeRoutes = tree.getRoutes();
+			if(node.index >= (int)nodeRoutes.size()) {
+				nodeRoutes.resize(tree.getCapacity(), nullptr);
+			}
+			nodeRoutes[node.index] = findRoute(node);
+			node.user = XMLUserData();
+			if(!userData.empty()) {
+				auto id = node.args.find("id");
+				auto data = id != node.args.end() ? userData.find(id->second.str()) : userData.end();
+				if(data != userData.end()) {
+					node.user = data->second;
+				}
+			}
+			if(node.type == ImGuiEnum::PLACEHOLDER) {
+				std::vector<XMLMount*>& nodeMounts = tree.getMounts();
+				if(node.index >= (int)nodeMounts.size()) {
+					nodeMounts.resize(tree.getCapacity(), nullptr);
+				}
+				auto id = node.args.find("id");
+				auto mount = id != node.args.end() ? mounts.find(id->second.str()) : mounts.end();
+				nodeMounts[node.index] = mount != mounts.end() ? &mount->second : nullptr;
+				if(mount != mounts.end() && mount->second.tree != nullptr) {
+					std::vector<const XMLTree*> visited;
+					checkMount(*mount->second.tree, tree, visited);
+				}
+			}
+		}
+
+		//Resolves the bind and route of a single node
+		void linkSingle(XMLNode& node, XMLTree& tree) {
+			linkCommon(node, tree);
+			if(node.type == ImGuiEnum::USE) {
+				linkUse(node, tree);
+				return;
+			}
+			if(node.type == ImGuiEnum::PUSHFONT) {
+				checkFont(node.args["font"]);
+			}
+			std::vector<XMLDynamicBind*>& slots = tree.getBinds();
+			auto dynamic = node.args.find("dynamic");
+			if(dynamic != node.args.end()) {
+				XMLDynamicBind& bind = findBind(dynamic->second.str());
+				if(!acceptsBind(node.type, bind.type)) {
+					throw std::runtime_error("Dynamic bind " + dynamic->second.str() + " of type " + bindTypeName(bind.type) + " does not match its widget");
+				}
+				if(node.bindSlot < 0) {
+					node.bindSlot = slots.size();
+					slots.push_back(nullptr);
+				}
+				if(slots[node.bindSlot] != &bind) {
+					slots[node.bindSlot] = &bind;
+					tree.setSlotGeneration(nextLinkGeneration());
+				}
+			} else if(node.bindSlot >= 0) {
+				slots[node.bindSlot] = nullptr;
+				node.bindSlot = -1;
+				tree.setSlotGeneration(nextLinkGeneration());
+			}
+		}
+
+		//Nodes of a template are shared by its uses, their bind slot is the position of the bind in the template
+		void linkTemplate(XMLNode& node, XMLTree& tree, int& ordinal) {
+			if(node.type == ImGuiEnum::USE || node.type == ImGuiEnum::TEMPLATE) {
+				throw std::runtime_error("Templates cannot contain use or template elements");
+			}
+			node.dirty = XMLDirty_None;
+			linkCommon(node, tree);
+			node.bindSlot = node.args.find("dynamic") != node.args.end() ? ordinal++ : -1;
+			for(auto child : node.children) {
+				linkTemplate(*child, tree, ordinal);
+			}
+		}
 
-		void renderMenu(XMLNode& node, XMLEventHandler& handler) {
+		//Binds of one instance, in the order linkTemplate numbered them
+		void linkInstance(const XMLNode& node, XMLNode& use, XMLTree& tree) {
+			std::vector<XMLDynamicBind*>& slots = tree.getBinds();
+			for(auto child : node.children) {
+				if(child->type == ImGuiEnum::PUSHFONT) {
+					checkFont(substitute(child->args["font"], &use));
+				}
+				auto dynamic = child->args.find("dynamic");
+				if(dynamic != child->args.end()) {
+					XMLString name = substitute(dynamic->second, &use);
+					if(name.empty()) {
+						throw std::runtime_error("Missing template parameter " + dynamic->second.str());
+					}
+					XMLDynamicBind& bind = findBind(name.str());
+					if(!acceptsBind(child->type, bind.type)) {
+						throw std::runtime_error("Dynamic bind " + name.str() + " of type " + bindTypeName(bind.type) + " does not match its widget");
+					}
+					if(use.bindSlot < 0) {
+						use.bindSlot = slots.size();
+					}
+					slots.push_back(&bind);
+				}
+				linkInstance(*child, use, tree);
+			}
+		}
+
+		//Resolves the template of a use and lays out the binds of the instance in consecutive slots
+		void linkUse(XMLNode& use, XMLTree& tree) {
+			std::vector<XMLNode*>& uses = tree.getTemplates();
+			if(use.index >= (int)uses.size()) {
+				uses.resize(tree.getCapacity(), nullptr);
+			}
+			XMLString name = use.args["template"];
+			XMLNode* shape = tree.findTemplate(name);
+			if(shape == nullptr) {
+				throw std::runtime_error("Unknown template " + name.str());
+			}
+			uses[use.index] = shape;
+			use.bindSlot = -1;
+			linkInstance(*shape, use, tree);
+			tree.setSlotGeneration(nextLinkGeneration());
+		}
+
+		void linkNode(XMLNode& node, XMLTree& tree) {
+			node.bindSlot = -1;
+			node.dirty = XMLDirty_None;
+			if(node.type == ImGuiEnum::TEMPLATE) {
+				int ordinal = 0;
+				for(auto child : node.children) {
+					linkTemplate(*child, tree, ordinal);
+				}
+				return;
+			}
+			linkSingle(node, tree);
+			for(auto child : node.children) {
+				linkNode(*child, tree);
+			}
+		}
+
+		//Only visits subtrees with dirty flags, nodes that did not change keep their links
+		void relinkDirty(XMLNode& node, XMLTree& tree) {
+			if(node.type == ImGuiEnum::TEMPLATE || node.type == ImGuiEnum::USE) {
+				relinkAll = true;
+				return;
+			}
+			if(node.dirty & XMLDirty_Node) {
+				linkSingle(node, tree);
+			}
+			int dirty = node.dirty;
+			node.dirty = XMLDirty_None;
+			if(dirty & (XMLDirty_Children | XMLDirty_Structure)) {
+				for(auto child : node.children) {
+					if(child->dirty != XMLDirty_None) {
+						relinkDirty(*child, tree);
+					}
+				}
+			}
+		}
+
+		//Links the tree if binds changed since its last link or relinks what changed in it
+		void prepare(XMLTree& tree) {
+			if(tree.getLinkGeneration() != bindGeneration) {
+				link(tree);
+			} else if(tree.isDirty()) {
+				relinkDirty(tree.getRoot(), tree);
+				if(relinkAll) {
+					relinkAll = false;
+					link(tree);
+				}
+			}
+		}
+
+		//Adds the slot of every bound node to layout, uses add the slots of their instance
+		void collectSlots(const XMLNode& node, XMLTree& tree, XMLBindLayout& layout, const XMLNode* use = nullptr, int* ordinal = nullptr) {
+			if(node.type == ImGuiEnum::TEMPLATE) {
+				return;
+			}
+			if(node.type == ImGuiEnum::USE) {
+				XMLNode* shape = node.index < (int)tree.getTemplates().size() ? tree.getTemplates()[node.index] : nullptr;
+				int count = 0;
+				if(shape != nullptr) {
+					for(auto child : shape->children) {
+						collectSlots(*child, tree, layout, &node, &count);
+					}
+				}
+				return;
+			}
+			auto dynamic = node.args.find("dynamic");
+			if(dynamic != node.args.end()) {
+				if(use != nullptr) {
+					layout.addSlot(substitute(dynamic->second, use).str(), use->bindSlot + (*ordinal)++);
+				} else if(node.bindSlot >= 0) {
+					layout.addSlot(dynamic->second.str(), node.bindSlot);
+				}
+			}
+			for(auto child : node.children) {
+				collectSlots(*child, tree, layout, use, ordinal);
+			}
+		}
+
+		//Copy of a bound value taken before its widget runs, only when an old/new callback needs it
+		struct OldValue
+		{
+			alignas(double) unsigned char small[16];
+			std::string copy;
+			const void* ptr = nullptr;
+
+			void capture(const XMLDynamicBind& bind, const void* value) {
+				if(bind.callbacks == nullptr || !bind.callbacks->onEvent) {
+					return;
+				}
+				if(bind.type == String) {
+					copy = *static_cast<const std::string*>(value);
+					ptr = &copy;
+				} else if(bind.size > sizeof(small)) {
+					copy.assign(static_cast<const char*>(value), bind.size);
+					ptr = copy.data();
+				} else {
+					std::memcpy(small, value, bind.size);
+					ptr = small;
+				}
+			}
+		};
+
+		void notifyChange(XMLDynamicBind& bind, const OldValue& old, const void* value) {
+			if(bind.callbacks == nullptr) {
+				return;
+			}
+			if(bind.callbacks->onChange) {
+				bind.callbacks->onChange();
+			}
+			if(bind.callbacks->onEvent) {
+				bind.callbacks->onEvent(old.ptr, value);
+			}
+		}
+
+		void dispatch(XMLNode& node, Handler& handler) {
+			XMLEventCallback* route = (*routes)[node.index];
+			if(route != nullptr) {
+				(*route)(node);
+			}
+			if(observer) {
+				observer(node);
+			}
+			handler.onEvent(node);
+		}
+
+		//Fonts are found by the name of their <font> element, see XMLFonts.h. nullptr when there is none,
+		//which PushFont takes as the default font.
+		static ImFont* findFont(std::string_view name) {
+			for(ImFont* font : ImGui::GetIO().Fonts->Fonts) {
+				if(font->ConfigData != nullptr && name == font->ConfigData->Name) {
+					return font;
+				}
+			}
+			return nullptr;
+		}
+
+		template<typename T>
+		T* bound(XMLNode& node) {
+			return static_cast<T*>(valueOf(node));
+		}
+
+		//Children deferred by a lazy read are parsed and linked the first time they are shown
+		void materialize(XMLNode& node) {
+			if(XMLTree::isLazy(node) && tree->materialize(node)) {
+				for(auto child : node.children) {
+					linkNode(*child, *tree);
+				}
+			}
+		}
+
+		//Renders a mounted tree in place of a placeholder, with the binds and routes of this renderer
+		void renderMounted(XMLTree& subtree, Handler& handler) {
+			if(subtree.isLocked()) {
+				throw std::runtime_error("Mounted tree is already being rendered");
+			}
+			auto outerBinds = binds;
+			auto outerRoutes = routes;
+			auto outerMounts = treeMounts;
+			auto outerTemplates = treeTemplates;
+			XMLTree* outer = tree;
+			const XMLNode* outerInstance = instance;
+			int outerOffset = slotOffset;
+			void* const* outerScope = scope;
+			std::size_t outerScopeSize = scopeSize;
+			instance = nullptr;
+			slotOffset = 0;
+			scope = nullptr;
+			auto restore = [&]() {
+				binds = outerBinds;
+				routes = outerRoutes;
+				treeMounts = outerMounts;
+				treeTemplates = outerTemplates;
+				tree = outer;
+				instance = outerInstance;
+				slotOffset = outerOffset;
+				scope = outerScope;
+				scopeSize = outerScopeSize;
+			};
+			try {
+				render(subtree, handler);
+			} catch(...) {
+				restore();
+				throw;
+			}
+			restore();
+		}
+
+		//Calls render on the shared nodes of a template with the parameters and bind slots of one use
+		template<typename Render>
+		void renderInstance(XMLNode& use, Render render) {
+			XMLNode* shape = use.index < (int)treeTemplates->size() ? (*treeTemplates)[use.index] : nullptr;
+			if(shape == nullptr) {
+				return;
+			}
+			const XMLNode* outerInstance = instance;
+			int outerOffset = slotOffset;
+			instance = &use;
+			slotOffset = use.bindSlot;
+			//Instances share labels, the use seeds the ImGui ids of its widgets unless the template has seed="false"
+			bool seed = shape->args["seed"] != "false";
+			if(seed) {
+				ImGui::PushID(use.index);
+			}
+			for(auto child : shape->children) {
+				render(*child);
+			}
+			if(seed) {
+				ImGui::PopID();
+			}
+			instance = outerInstance;
+			slotOffset = outerOffset;
+		}
+
+		//Entry of an open menu, a use stands for the entries of its template
+		void renderMenuEntry(XMLNode& node, Handler& handler) {
+			if(node.type == ImGuiEnum::MENUITEM) {
+				if(ImGui::MenuItem(arg(node, "label").c_str())) {
+					dispatch(node, handler);
+				}
+			} else if(node.type == ImGuiEnum::MENU) {
+				renderMenu(node, handler);
+			} else if(node.type == ImGuiEnum::USE) {
+				renderInstance(node, [&](XMLNode& entry) { renderMenuEntry(entry, handler); });
+			}
+		}
+
+		void renderMenu(XMLNode& node, Handler& handler) {
 			if(node.type == ImGuiEnum::MENU) {
-				if(ImGui::BeginMenu(node.args["label"].c_str())) {
+				if(ImGui::BeginMenu(arg(node, "label").c_str())) {
+					materialize(node);
 					for(auto child : node.children) {
-						if(child->type == ImGuiEnum::MENUITEM) {
-							if(ImGui::MenuItem(child->args["label"].c_str())) {
-								handler.onEvent(*child);
-							}
-						} else if(child->type == ImGuiEnum::MENU) {
-							renderMenu(*child, handler);
-						}
+						renderMenuEntry(*child, handler);
 					}
 					ImGui::EndMenu();
 				}
+			} else if(node.type == ImGuiEnum::USE) {
+				renderInstance(node, [&](XMLNode& menu) { renderMenu(menu, handler); });
 			}
 		}
 
-		void renderTree(XMLNode& node, XMLEventHandler& handler) {
+		void renderTree(XMLNode& node, Handler& handler) {
 			if(node.type == ImGuiEnum::TREENODE) {
-				if(ImGui::TreeNode(node.args["label"].c_str())) {
-					handler.onEvent(node);
+				if(ImGui::TreeNode(arg(node, "label").c_str())) {
+					materialize(node);
+					dispatch(node, handler);
 					for(auto child : node.children) {
 						renderTree(*child, handler);
 					}
@@ -45,25 +551,30 @@ namespace ImXML {
 				for(auto child : node.children) {
 					renderTree(*child, handler);
 				}
+			} else if(node.type == ImGuiEnum::USE) {
+				renderInstance(node, [&](XMLNode& child) { renderTree(child, handler); });
 			} else {
 				onNodeBegin(node, handler);
 			}
 		}
 
-		void onNodeBegin(XMLNode& node, XMLEventHandler& handler, bool inPopup=false) {
+		void onNodeBegin(XMLNode& node, Handler& handler, bool inPopup=false) {
 			handler.onNodeBegin(node);
 			if(!inPopup && popup) {
 				return;
 			}
 			
-			if(sameline == 1) {
-				sameline++;
-			} else if(sameline == 2) {
-				ImGui::SameLine();
+			//Uses draw nothing themselves, the nodes of their template take their place on the line
+			if(node.type != ImGuiEnum::USE) {
+				if(sameline == 1) {
+					sameline++;
+				} else if(sameline == 2) {
+					ImGui::SameLine();
+				}
 			}
 
 			if(node.type == ImGuiEnum::COLUMNS) {
-				ImGui::Columns(std::stoi(node.args["count"]));
+				ImGui::Columns(std::atoi(arg(node, "count").c_str()));
 			}
 
 			if(node.type == ImGuiEnum::MENUBAR) {
@@ -76,16 +587,34 @@ namespace ImXML {
 			}
 			
 			if(node.type == ImGuiEnum::BEGIN) {
-				ImGui::Begin(node.args["name"].c_str(), nullptr, node.flags);
+				ImGui::Begin(arg(node, "name").c_str(), nullptr, node.flags);
 			}
 
 			if(node.type == ImGuiEnum::GROUP) {
 				ImGui::BeginGroup();
 			}
 
+			if(node.type == ImGuiEnum::PUSHFONT) {
+				ImGui::PushFont(findFont(arg(node, "font")));
+			}
+
+			if(node.type == ImGuiEnum::USE) {
+				renderInstance(node, [&](XMLNode& child) { traverse(child, handler, inPopup); });
+			}
+
+			if(node.type == ImGuiEnum::PLACEHOLDER) {
+				XMLMount* mount = node.index < (int)treeMounts->size() ? (*treeMounts)[node.index] : nullptr;
+				if(mount != nullptr && mount->draw) {
+					mount->draw(node);
+				} else if(mount != nullptr && mount->tree != nullptr) {
+					renderMounted(*mount->tree, handler);
+				}
+			}
+
 			if(node.type == ImGuiEnum::POPUPCONTEXTWINDOW) {
 				popup = true;
 				if(ImGui::BeginPopupContextWindow()) {
+					materialize(node);
 					for(auto child : node.children) {
 						traverse(*child, handler, true);
 					}
@@ -93,35 +622,85 @@ namespace ImXML {
 				}
 			}
 
+			//Value widgets report edits through their return value, callbacks only run for those frames
+			bool edited = false;
+			OldValue old;
+			if(node.bindSlot >= 0 && node.type != ImGuiEnum::USE) {
+				old.capture(*slot(node), valueOf(node));
+			}
+
 			if(node.type == ImGuiEnum::COLORPICKER3) {
-				ImGui::ColorPicker3(node.args["label"].c_str(), (float*)dynamicBinds.at(node.args["dynamic"]).ptr);
+				edited = ImGui::ColorPicker3(arg(node, "label").c_str(), bound<float>(node));
 			}
 			if(node.type == ImGuiEnum::COLORPICKER4) {
-				ImGui::ColorPicker4(node.args["label"].c_str(), (float*)dynamicBinds.at(node.args["dynamic"]).ptr);
+				edited = ImGui::ColorPicker4(arg(node, "label").c_str(), bound<float>(node));
 			}
 			if(node.type == ImGuiEnum::COLOREDIT3) {
-				ImGui::ColorEdit3(node.args["label"].c_str(), (float*)dynamicBinds.at(node.args["dynamic"]).ptr);
+				edited = ImGui::ColorEdit3(arg(node, "label").c_str(), bound<float>(node));
 			}
 			if(node.type == ImGuiEnum::COLOREDIT4) {
-				ImGui::ColorEdit4(node.args["label"].c_str(), (float*)dynamicBinds.at(node.args["dynamic"]).ptr);
+				edited = ImGui::ColorEdit4(arg(node, "label").c_str(), bound<float>(node));
 			}
 
 			if(node.type == ImGuiEnum::BUTTON) {
-				if(ImGui::Button(node.args["label"].c_str())) {
-					handler.onEvent(node);
+				if(ImGui::Button(arg(node, "label").c_str())) {
+					dispatch(node, handler);
 				}
 			}
 
 			if(node.type == ImGuiEnum::TEXT) {
-				ImGui::Text("%s", node.args["label"].c_str());
+				ImGui::Text("%s", arg(node, "label").c_str());
 			}
 
 			if(node.type == ImGuiEnum::SLIDERFLOAT) {
-				ImGui::SliderFloat(node.args["label"].c_str(), (float*)dynamicBinds.at(node.args["dynamic"]).ptr, std::stof(node.args["min"]), std::stof(node.args["max"]));
+				edited = ImGui::SliderFloat(arg(node, "label").c_str(), bound<float>(node), std::strtof(arg(node, "min").c_str(), nullptr), std::strtof(arg(node, "max").c_str(), nullptr));
+			}
+
+			if(node.type == ImGuiEnum::SLIDERINT) {
+				edited = ImGui::SliderInt(arg(node, "label").c_str(), bound<int>(node), std::atoi(arg(node, "min").c_str()), std::atoi(arg(node, "max").c_str()));
+			}
+
+			if(node.type == ImGuiEnum::INPUTFLOAT) {
+				edited = ImGui::InputFloat(arg(node, "label").c_str(), bound<float>(node));
+			}
+
+			if(node.type == ImGuiEnum::INPUTINT) {
+				edited = ImGui::InputInt(arg(node, "label").c_str(), bound<int>(node));
+			}
+
+			if(node.type == ImGuiEnum::INPUTDOUBLE) {
+				edited = ImGui::InputDouble(arg(node, "label").c_str(), bound<double>(node));
+			}
+
+			if(node.type == ImGuiEnum::CHECKBOX) {
+				edited = ImGui::Checkbox(arg(node, "label").c_str(), bound<bool>(node));
+			}
+
+			if(node.type == ImGuiEnum::RADIOBUTTON) {
+				XMLDynamicBind& bind = *slot(node);
+				int value = std::atoi(arg(node, "value").c_str());
+				if(bind.type == Enum) {
+					void* ptr = valueOf(node);
+					if(ImGui::RadioButton(arg(node, "label").c_str(), bind.getEnum(ptr) == value)) {
+						bind.setEnum(ptr, value);
+						edited = true;
+					}
+				} else {
+					edited = ImGui::RadioButton(arg(node, "label").c_str(), bound<int>(node), value);
+				}
 			}
 
 			if(node.type == ImGuiEnum::INPUTTEXT) {
-				ImGui::InputText(node.args["label"].c_str(), (char*)dynamicBinds.at(node.args["dynamic"]).ptr, dynamicBinds.at(node.args["dynamic"]).size, node.flags);
+				XMLDynamicBind& bind = *slot(node);
+				if(bind.type == String) {
+					edited = ImGui::InputText(arg(node, "label").c_str(), bound<std::string>(node), node.flags);
+				} else {
+					edited = ImGui::InputText(arg(node, "label").c_str(), bound<char>(node), bind.size, node.flags);
+				}
+			}
+
+			if(edited) {
+				notifyChange(*slot(node), old, valueOf(node));
 			}
 
 			if(node.type == ImGuiEnum::TREE) {
@@ -137,7 +716,7 @@ namespace ImXML {
 			}
 		}
 
-		void onNodeEnd(XMLNode& node, XMLEventHandler& handler, bool inPopup=false) {
+		void onNodeEnd(XMLNode& node, Handler& handler, bool inPopup=false) {
 			if(node.type == ImGuiEnum::BEGIN) {
 				ImGui::End();
 			}
@@ -153,10 +732,16 @@ namespace ImXML {
 			if(node.type == ImGuiEnum::GROUP) {
 				ImGui::EndGroup();
 			}
+			if(node.type == ImGuiEnum::PUSHFONT) {
+				ImGui::PopFont();
+			}
 			handler.onNodeEnd(node);
 		}
 
-		void traverse(XMLNode& root, XMLEventHandler& handler, bool inPopup=false) {
+		void traverse(XMLNode& root, Handler& handler, bool inPopup=false) {
+			if(root.type == ImGuiEnum::TEMPLATE) {
+				return;
+			}
 			onNodeBegin(root, handler, inPopup);
 			for(auto child : root.children) {
 				traverse(*child, handler, inPopup);
@@ -164,26 +749,166 @@ namespace ImXML {
 			onNodeEnd(root, handler, inPopup);
 		}
 	public:
-		XMLRenderer(/* args */);
-		~XMLRenderer();
+		BasicXMLRenderer(/* args */);
+		~BasicXMLRenderer();
 
-		void render(XMLTree& tree, XMLEventHandler& handler) {
-			XMLNode root = tree.getRoot();
-			traverse(root, handler);
+		void render(XMLTree& tree, Handler& handler) {
+			prepare(tree);
+			binds = &tree.getBinds();
+			routes = &tree.getRoutes();
+			treeMounts = &tree.getMounts();
+			treeTemplates = &tree.getTemplates();
+			this->tree = &tree;
+			XMLTreeLock lock(tree);
+			traverse(tree.getRoot(), handler);
+		}
+
+		//Renders the tree against the values of scope instead of the binds of the renderer, without relinking.
+		//Several scopes of one tree can be rendered in a frame, push an ImGui id per scope to keep widgets apart.
+		void render(XMLTree& tree, Handler& handler, const XMLBindScope& bindScope) {
+			prepare(tree);
+			if(bindScope.slotGeneration != tree.getSlotGeneration() || bindScope.ptrs.size() < tree.getBinds().size()) {
+				throw std::runtime_error("Bind scope does not match the linked tree, make it again from a new bindLayout");
+			}
+			scope = bindScope.ptrs.data();
+			scopeSize = bindScope.ptrs.size();
+			try {
+				render(tree, handler);
+			} catch(...) {
+				scope = nullptr;
+				throw;
+			}
+			scope = nullptr;
+		}
+
+		//Bind slots of the tree by name, links the tree first if needed. Scopes made from the layout stay
+		//valid until binds are added to the renderer or the tree changes.
+		XMLBindLayout bindLayout(XMLTree& tree) {
+			prepare(tree);
+			XMLBindLayout layout(tree.getBinds(), tree.getSlotGeneration());
+			collectSlots(tree.getRoot(), tree, layout);
+			return layout;
+		}
+
+		//Renders the placeholder of an async read until its tree is ready, then swaps it in before the frame
+		void render(XMLAsyncRead& read, Handler& handler) {
+			read.update();
+			render(read.getTree(), handler);
+		}
+
+		//Resolves every dynamic attribute of the tree to its bind and checks it against the widget type.
+		//Called by render whenever binds changed since the last link, throws on unknown or mismatched binds.
+		//Mutations of a linked tree are picked up by render through the dirty flags instead.
+		void link(XMLTree& tree) {
+			tree.getBinds().clear();
+			tree.getRoutes().assign(tree.getCapacity(), nullptr);
+			tree.getMounts().clear();
+			tree.getTemplates().clear();
+			linkNode(tree.getRoot(), tree);
+			tree.setLinkGeneration(bindGeneration);
+			tree.setSlotGeneration(nextLinkGeneration());
 		}
 
 		void addDynamicBind(const std::string& name, const XMLDynamicBind& bind) {
-			dynamicBinds.insert({name, bind});
+			dynamicBinds.insert_or_assign(name, bind);
+			invalidateLinks();
+		}
+
+		//Binds float, int, bool, double, float[3], float[4], char[N], std::string and enum values.
+		//Structs registered with IMXML_SCHEMA are bound as a whole and reached with paths like name.field[1].value
+		template<typename T>
+		void addBind(const std::string& name, T& value) {
+			if constexpr (hasSchema<T>::value) {
+				structBinds.insert_or_assign(name, makeStructBind(value));
+				invalidateLinks();
+			} else {
+				addDynamicBind(name, makeBind(value));
+			}
+		}
+
+		//Called on events of the node with this id, resolved once per node when the tree is linked
+		void on(const std::string& id, XMLEventCallback callback) {
+			idRoutes.insert_or_assign(id, std::move(callback));
+			invalidateLinks();
+		}
+
+		//Called on events of every node of this tag that has no id route
+		void on(ImGuiEnum tag, XMLEventCallback callback) {
+			tagRoutes.insert_or_assign(tag, std::move(callback));
+			invalidateLinks();
+		}
+
+		//<use> node whose template is being rendered, for handlers and routes called with a template node
+		const XMLNode* getInstance() const {
+			return instance;
+		}
+
+		//Runs draw in place of <placeholder id="id"/>, resolved once per placeholder when the tree is linked
+		void mount(const std::string& id, XMLEventCallback draw) {
+			mounts.insert_or_assign(id, XMLMount{std::move(draw), nullptr});
+			invalidateLinks();
+		}
+
+		//Renders subtree in place of <placeholder id="id"/> with the binds and routes of this renderer.
+		//subtree must outlive the mount and may itself contain mounted placeholders.
+		void mount(const std::string& id, XMLTree& subtree) {
+			mounts.insert_or_assign(id, XMLMount{nullptr, &subtree});
+			invalidateLinks();
+		}
+
+		void unmount(const std::string& id) {
+			mounts.erase(id);
+			invalidateLinks();
+		}
+
+		//Attaches object to the node with this id when the tree is linked, handlers then reach it with
+		//node.getUserData<T>() instead of looking the id up every frame
+		template<typename T>
+		void attach(const std::string& id, T& object) {
+			userData.insert_or_assign(id, XMLUserData::make(&object));
+			invalidateLinks();
+		}
+
+		void detach(const std::string& id) {
+			userData.erase(id);
+			invalidateLinks();
+		}
+
+		//Called on every event before the handler, used to record sessions
+		void setEventObserver(XMLEventCallback callback) {
+			observer = std::move(callback);
+		}
+
+		//Called after a widget bound to name reports an edit
+		void onChange(const std::string& name, std::function<void()> callback) {
+			bindCallbacks[name].onChange = std::move(callback);
+			invalidateLinks();
+		}
+
+		//Same as onChange but also receives the value from before the edit, T must be the bound type
+		template<typename T>
+		void onChangeEvent(const std::string& name, std::function<void(const T& oldValue, const T& newValue)> callback) {
+			XMLBindCallbacks& callbacks = bindCallbacks[name];
+			callbacks.onEvent = [callback](const void* oldValue, const void* newValue) {
+				callback(*static_cast<const T*>(oldValue), *static_cast<const T*>(newValue));
+			};
+			callbacks.eventType = XMLBindTraits<T>::type;
+			callbacks.eventSize = sizeof(T);
+			invalidateLinks();
 		}
 	};
 	
-	XMLRenderer::XMLRenderer(/* args */)
+	template<typename Handler>
+	BasicXMLRenderer<Handler>::BasicXMLRenderer(/* args */)
 	{
 	}
 	
-	XMLRenderer::~XMLRenderer()
+	template<typename Handler>
+	BasicXMLRenderer<Handler>::~BasicXMLRenderer()
 	{
 	}
+
+	using XMLRenderer = BasicXMLRenderer<XMLEventHandler>;
 	
 }
 
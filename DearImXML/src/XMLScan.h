@@ -0,0 +1,143 @@
+#ifndef DEARIMXML_XMLSCAN_H
+#define DEARIMXML_XMLSCAN_H
+
+#include <cstdint>
+#include <cstring>
+#include <string_view>
+#include <vector>
+
+#if defined(__x86_64__) || defined(_M_X64)
+#define DEARIMXML_SCAN_X86
+#include <immintrin.h>
+//The AVX2 scanner is compiled for its own target, which MSVC cannot do without /arch:AVX2 for the whole build
+#if defined(__GNUC__) || defined(__clang__)
+#define DEARIMXML_SCAN_AVX2
+#endif
+#endif
+
+namespace ImXML {
+
+	//Instruction sets the structural scanner can use, the best one supported by the CPU is picked at runtime
+	enum XMLScanLevel {
+		XMLScan_Scalar,
+		XMLScan_SSE2,
+		XMLScan_AVX2,
+	};
+
+	inline bool isStructural(char c) {
+		return c == '<' || c == '>' || c == '"' || c == '\'';
+	}
+
+	inline uint32_t countTrailingZeros(uint64_t mask) {
+#if defined(_MSC_VER)
+		unsigned long index;
+		_BitScanForward64(&index, mask);
+		return index;
+#else
+		return __builtin_ctzll(mask);
+#endif
+	}
+
+	//Appends base + position of every set bit
+	inline void appendPositions(uint64_t mask, uint32_t base, std::vector<uint32_t>& out) {
+		while(mask != 0) {
+			out.push_back(base + countTrailingZeros(mask));
+			mask &= mask - 1;
+		}
+	}
+
+	inline void scanScalar(std::string_view data, std::size_t from, std::vector<uint32_t>& out) {
+		for(std::size_t i = from; i < data.size(); i++) {
+			if(isStructural(data[i])) {
+				out.push_back(i);
+			}
+		}
+	}
+
+#ifdef DEARIMXML_SCAN_X86
+	inline void scanSSE2(std::string_view data, std::vector<uint32_t>& out) {
+		const __m128i lt = _mm_set1_epi8('<');
+		const __m128i gt = _mm_set1_epi8('>');
+		const __m128i dq = _mm_set1_epi8('"');
+		const __m128i sq = _mm_set1_epi8('\'');
+		auto classify = [&](const char* p) -> uint64_t {
+			__m128i v = _mm_loadu_si128(reinterpret_cast<const __m128i*>(p));
+			__m128i hit = _mm_or_si128(_mm_or_si128(_mm_cmpeq_epi8(v, lt), _mm_cmpeq_epi8(v, gt)), _mm_or_si128(_mm_cmpeq_epi8(v, dq), _mm_cmpeq_epi8(v, sq)));
+			return (uint32_t)_mm_movemask_epi8(hit);
+		};
+		std::size_t i = 0;
+		for(; i + 64 <= data.size(); i += 64) {
+			const char* p = data.data() + i;
+			uint64_t mask = classify(p) | classify(p + 16) << 16 | classify(p + 32) << 32 | classify(p + 48) << 48;
+			appendPositions(mask, i, out);
+		}
+		scanScalar(data, i, out);
+	}
+#endif
+
+#ifdef DEARIMXML_SCAN_AVX2
+	__attribute__((target("avx2"))) inline void scanAVX2(std::string_view data, std::vector<uint32_t>& out) {
+		const __m256i lt = _mm256_set1_epi8('<');
+		const __m256i gt = _mm256_set1_epi8('>');
+		const __m256i dq = _mm256_set1_epi8('"');
+		const __m256i sq = _mm256_set1_epi8('\'');
+		std::size_t i = 0;
+		for(; i + 64 <= data.size(); i += 64) {
+			const char* p = data.data() + i;
+			__m256i a = _mm256_loadu_si256(reinterpret_cast<const __m256i*>(p));
+			__m256i b = _mm256_loadu_si256(reinterpret_cast<const __m256i*>(p + 32));
+			__m256i hitA = _mm256_or_si256(_mm256_or_si256(_mm256_cmpeq_epi8(a, lt), _mm256_cmpeq_epi8(a, gt)), _mm256_or_si256(_mm256_cmpeq_epi8(a, dq), _mm256_cmpeq_epi8(a, sq)));
+			__m256i hitB = _mm256_or_si256(_mm256_or_si256(_mm256_cmpeq_epi8(b, lt), _mm256_cmpeq_epi8(b, gt)), _mm256_or_si256(_mm256_cmpeq_epi8(b, dq), _mm256_cmpeq_epi8(b, sq)));
+			uint64_t mask = (uint32_t)_mm256_movemask_epi8(hitA) | (uint64_t)(uint32_t)_mm256_movemask_epi8(hitB) << 32;
+			appendPositions(mask, i, out);
+		}
+		scanScalar(data, i, out);
+	}
+#endif
+
+	inline XMLScanLevel detectScanLevel() {
+#if defined(DEARIMXML_SCAN_AVX2)
+		__builtin_cpu_init();
+		if(__builtin_cpu_supports("avx2")) {
+			return XMLScan_AVX2;
+		}
+		return XMLScan_SSE2;
+#elif defined(DEARIMXML_SCAN_X86)
+		return XMLScan_SSE2;
+#else
+		return XMLScan_Scalar;
+#endif
+	}
+
+	//Level used by buildStructuralIndex, detected once. Can be lowered to compare implementations.
+	inline XMLScanLevel& scanLevel() {
+		static XMLScanLevel level = detectScanLevel();
+		return level;
+	}
+
+	//Positions of every <, >, " and ' in data, in order. XMLReader uses it only to split the root content
+	//of large documents into ranges for the parallel parse, its tag and quote state machine visits just
+	//these positions. The ranges themselves, and documents parsed as one range, are tokenized byte by byte.
+	inline void buildStructuralIndex(std::string_view data, std::vector<uint32_t>& out) {
+		out.clear();
+		out.reserve(data.size() / 8);
+		switch(scanLevel()) {
+#ifdef DEARIMXML_SCAN_AVX2
+			case XMLScan_AVX2:
+				scanAVX2(data, out);
+				return;
+#endif
+#ifdef DEARIMXML_SCAN_X86
+			case XMLScan_SSE2:
+				scanSSE2(data, out);
+				return;
+#endif
+			default:
+				scanScalar(data, 0, out);
+				return;
+		}
+	}
+
+}
+
+#endif /* DEARIMXML_XMLSCAN_H */
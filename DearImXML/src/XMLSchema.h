@@ -0,0 +1,124 @@
+#ifndef DEARIMXML_XMLSCHEMA_H
+#define DEARIMXML_XMLSCHEMA_H
+
+#include <XMLDynamicBind.h>
+#include <array>
+#include <cstddef>
+#include <string_view>
+#include <type_traits>
+#include <utility>
+#include <vector>
+
+namespace ImXML {
+
+	//Resolves the rest of a path (".arm.angle", "[2].x" or "" for the value itself) from an object to a bind
+	using XMLPathResolver = bool (*)(void* object, std::string_view path, XMLDynamicBind& out);
+
+	struct XMLField
+	{
+		const char* name;
+		XMLPathResolver resolve;
+	};
+
+	template<typename T, typename Enable = void>
+	struct hasBindTraits : std::false_type {};
+	template<typename T>
+	struct hasBindTraits<T, std::void_t<decltype(XMLBindTraits<T>::type)>> : std::true_type {};
+
+	//Structs are registered with IMXML_SCHEMA, which declares imxmlSchema(const T*) next to the struct
+	template<typename T, typename Enable = void>
+	struct hasSchema : std::false_type {};
+	template<typename T>
+	struct hasSchema<T, std::void_t<decltype(imxmlSchema(std::declval<const T*>()))>> : std::true_type {};
+
+	template<typename T>
+	struct arrayTraits { static constexpr std::size_t count = 0; };
+	template<typename T, std::size_t N>
+	struct arrayTraits<T[N]> { using Element = T; static constexpr std::size_t count = N; };
+	template<typename T, std::size_t N>
+	struct arrayTraits<std::array<T, N>> { using Element = T; static constexpr std::size_t count = N; };
+
+	template<typename T>
+	bool resolvePath(void* object, std::string_view path, XMLDynamicBind& out) {
+		T& value = *static_cast<T*>(object);
+		if(path.empty()) {
+			if constexpr (hasBindTraits<T>::value) {
+				out = makeBind(value);
+				return true;
+			}
+			return false;
+		}
+		if(path.front() == '[') {
+			if constexpr (arrayTraits<T>::count > 0) {
+				std::size_t close = path.find(']');
+				if(close == std::string_view::npos || close == 1) {
+					return false;
+				}
+				std::size_t index = 0;
+				for(char c : path.substr(1, close-1)) {
+					if(c < '0' || c > '9') {
+						return false;
+					}
+					index = index*10 + (c - '0');
+				}
+				if(index >= arrayTraits<T>::count) {
+					return false;
+				}
+				using Element = typename arrayTraits<T>::Element;
+				return resolvePath<Element>(&value[index], path.substr(close+1), out);
+			}
+			return false;
+		}
+		if(path.front() == '.') {
+			if constexpr (hasSchema<T>::value) {
+				path.remove_prefix(1);
+				std::size_t end = path.find_first_of(".[");
+				std::string_view name = path.substr(0, end);
+				for(const XMLField& field : imxmlSchema(static_cast<const T*>(nullptr))) {
+					if(name == field.name) {
+						return field.resolve(object, end == std::string_view::npos ? std::string_view() : path.substr(end), out);
+					}
+				}
+			}
+		}
+		return false;
+	}
+
+	template<typename T>
+	struct memberTraits;
+	template<typename S, typename M>
+	struct memberTraits<M S::*> { using Struct = S; using Type = M; };
+
+	template<auto Member>
+	bool resolveMember(void* object, std::string_view path, XMLDynamicBind& out) {
+		using Traits = memberTraits<decltype(Member)>;
+		auto& member = static_cast<typename Traits::Struct*>(object)->*Member;
+		return resolvePath<typename Traits::Type>(&member, path, out);
+	}
+
+	//A registered struct instance bound under a name, paths below it are resolved when a tree is linked
+	struct XMLStructBind
+	{
+		void* ptr;
+		XMLPathResolver resolve;
+	};
+
+	template<typename T>
+	XMLStructBind makeStructBind(T& value) {
+		return {&value, &resolvePath<T>};
+	}
+
+}
+
+//Registers the fields of a struct for path binds, e.g. IMXML_SCHEMA(Robot, IMXML_FIELD(arm), IMXML_FIELD(speed))
+//Must be used in the namespace of the struct.
+#define IMXML_SCHEMA(Type, ...) \
+	inline const std::vector<ImXML::XMLField>& imxmlSchema(const Type*) { \
+		using Self = Type; \
+		static const std::vector<ImXML::XMLField> fields = { __VA_ARGS__ }; \
+		return fields; \
+	}
+
+#define IMXML_FIELD(member) ImXML::XMLField{#member, &ImXML::resolveMember<&Self::member>}
+
+#endif /* DEARIMXML_XMLSCHEMA_H */
@@ -0,0 +1,303 @@
+#ifndef DEARIMXML_XMLSESSION_H
+#define DEARIMXML_XMLSESSION_H
+
+#include <XMLTree.h>
+#include <ImGUI/imgui.h>
+#include <ImGUI/imgui_internal.h>
+#include <cstdint>
+#include <fstream>
+#include <stdexcept>
+#include <string>
+#include <vector>
+
+namespace ImXML {
+
+	struct XMLSessionFrame
+	{
+		float deltaTime;
+		ImVec2 displaySize;
+		//Input events queued by the backend for this frame
+		std::vector<ImGuiInputEvent> inputs;
+		//Index of every node that fired an event during this frame, in order
+		std::vector<uint32_t> events;
+	};
+
+	//Per frame ImGuiIO input and resulting node events of a session, stored in a compact binary file
+	class XMLSession
+	{
+	private:
+		static constexpr uint32_t magic = 0x53584d49; //"IMXS"
+		static constexpr uint32_t version = 1;
+		std::vector<XMLSessionFrame> frames;
+
+		template<typename T>
+		static void put(std::ofstream& file, T value) {
+			file.write(reinterpret_cast<const char*>(&value), sizeof(T));
+		}
+
+		template<typename T>
+		static T get(std::ifstream& file) {
+			T value;
+			if(!file.read(reinterpret_cast<char*>(&value), sizeof(T))) {
+				throw std::runtime_error("Truncated session file");
+			}
+			return value;
+		}
+	public:
+		XMLSession();
+		~XMLSession();
+
+		std::vector<XMLSessionFrame>& getFrames() {
+			return frames;
+		}
+
+		void save(const std::string& filename) const;
+		void load(const std::string& filename);
+	};
+
+	XMLSession::XMLSession()
+	{
+	}
+
+	XMLSession::~XMLSession()
+	{
+	}
+
+	void XMLSession::save(const std::string& filename) const {
+		std::ofstream file(filename, std::ios::binary);
+		put<uint32_t>(file, magic);
+		put<uint32_t>(file, version);
+		put<uint32_t>(file, frames.size());
+		for(const XMLSessionFrame& frame : frames) {
+			put<float>(file, frame.deltaTime);
+			put<float>(file, frame.displaySize.x);
+			put<float>(file, frame.displaySize.y);
+			put<uint32_t>(file, frame.inputs.size());
+			for(const ImGuiInputEvent& input : frame.inputs) {
+				put<uint8_t>(file, input.Type);
+				switch(input.Type) {
+					case ImGuiInputEventType_MousePos:
+						put<uint8_t>(file, input.MousePos.MouseSource);
+						put<float>(file, input.MousePos.PosX);
+						put<float>(file, input.MousePos.PosY);
+						break;
+					case ImGuiInputEventType_MouseWheel:
+						put<uint8_t>(file, input.MouseWheel.MouseSource);
+						put<float>(file, input.MouseWheel.WheelX);
+						put<float>(file, input.MouseWheel.WheelY);
+						break;
+					case ImGuiInputEventType_MouseButton:
+						put<uint8_t>(file, input.MouseButton.MouseSource);
+						put<uint8_t>(file, input.MouseButton.Button);
+						put<uint8_t>(file, input.MouseButton.Down);
+						break;
+					case ImGuiInputEventType_MouseViewport:
+						put<uint32_t>(file, input.MouseViewport.HoveredViewportID);
+						break;
+					case ImGuiInputEventType_Key:
+						put<int32_t>(file, input.Key.Key);
+						put<uint8_t>(file, input.Key.Down);
+						put<float>(file, input.Key.AnalogValue);
+						break;
+					case ImGuiInputEventType_Text:
+						put<uint32_t>(file, input.Text.Char);
+						break;
+					case ImGuiInputEventType_Focus:
+						put<uint8_t>(file, input.AppFocused.Focused);
+						break;
+					default:
+						break;
+				}
+			}
+			put<uint32_t>(file, frame.events.size());
+			for(uint32_t event : frame.events) {
+				put<uint32_t>(file, event);
+			}
+		}
+	}
+
+	void XMLSession::load(const std::string& filename) {
+		std::ifstream file(filename, std::ios::binary);
+		if(get<uint32_t>(file) != magic || get<uint32_t>(file) != version) {
+			throw std::runtime_error("Invalid session file " + filename);
+		}
+		frames.resize(get<uint32_t>(file));
+		for(XMLSessionFrame& frame : frames) {
+			frame.deltaTime = get<float>(file);
+			frame.displaySize.x = get<float>(file);
+			frame.displaySize.y = get<float>(file);
+			frame.inputs.resize(get<uint32_t>(file));
+			for(ImGuiInputEvent& input : frame.inputs) {
+				input.Type = static_cast<ImGuiInputEventType>(get<uint8_t>(file));
+				switch(input.Type) {
+					case ImGuiInputEventType_MousePos:
+						input.MousePos.MouseSource = static_cast<ImGuiMouseSource>(get<uint8_t>(file));
+						input.MousePos.PosX = get<float>(file);
+						input.MousePos.PosY = get<float>(file);
+						break;
+					case ImGuiInputEventType_MouseWheel:
+						input.MouseWheel.MouseSource = static_cast<ImGuiMouseSource>(get<uint8_t>(file));
+						input.MouseWheel.WheelX = get<float>(file);
+						input.MouseWheel.WheelY = get<float>(file);
+						break;
+					case ImGuiInputEventType_MouseButton:
+						input.MouseButton.MouseSource = static_cast<ImGuiMouseSource>(get<uint8_t>(file));
+						input.MouseButton.Button = get<uint8_t>(file);
+						input.MouseButton.Down = get<uint8_t>(file);
+						break;
+					case ImGuiInputEventType_MouseViewport:
+						input.MouseViewport.HoveredViewportID = get<uint32_t>(file);
+						break;
+					case ImGuiInputEventType_Key:
+						input.Key.Key = static_cast<ImGuiKey>(get<int32_t>(file));
+						input.Key.Down = get<uint8_t>(file);
+						input.Key.AnalogValue = get<float>(file);
+						break;
+					case ImGuiInputEventType_Text:
+						input.Text.Char = get<uint32_t>(file);
+						break;
+					case ImGuiInputEventType_Focus:
+						input.AppFocused.Focused = get<uint8_t>(file);
+						break;
+					default:
+						throw std::runtime_error("Invalid input event in session file " + filename);
+				}
+			}
+			frame.events.resize(get<uint32_t>(file));
+			for(uint32_t& event : frame.events) {
+				event = get<uint32_t>(file);
+			}
+		}
+	}
+
+	//Records a live session: call beginFrame after the backend NewFrame and before ImGui::NewFrame,
+	//endFrame after rendering, and pass observer() to the renderer with setEventObserver
+	class XMLRecorder
+	{
+	private:
+		XMLSession& session;
+		XMLSessionFrame frame;
+		ImU32 lastEventId = 0;
+	public:
+		XMLRecorder(XMLSession& session);
+		~XMLRecorder();
+
+		void beginFrame() {
+			ImGuiContext& g = *ImGui::GetCurrentContext();
+			frame.deltaTime = g.IO.DeltaTime;
+			frame.displaySize = g.IO.DisplaySize;
+			frame.inputs.clear();
+			frame.events.clear();
+			//Events may be trickled over several frames, only record the ones queued since last frame
+			for(const ImGuiInputEvent& input : g.InputEventsQueue) {
+				if(input.EventId > lastEventId) {
+					frame.inputs.push_back(input);
+					lastEventId = input.EventId;
+				}
+			}
+		}
+
+		void endFrame() {
+			session.getFrames().push_back(frame);
+		}
+
+		XMLEventCallback observer() {
+			return [this](XMLNode& node) {
+				frame.events.push_back(node.index);
+			};
+		}
+	};
+
+	XMLRecorder::XMLRecorder(XMLSession& session) : session(session)
+	{
+	}
+
+	XMLRecorder::~XMLRecorder()
+	{
+	}
+
+	//Feeds a recorded session into the current context, one frame per beginFrame/endFrame pair,
+	//and counts frames whose events differ from the recording
+	class XMLReplayer
+	{
+	private:
+		XMLSession& session;
+		std::size_t next = 0;
+		std::vector<uint32_t> events;
+		unsigned int mismatches = 0;
+	public:
+		XMLReplayer(XMLSession& session);
+		~XMLReplayer();
+
+		//Returns false once every frame was replayed
+		bool beginFrame() {
+			if(next >= session.getFrames().size()) {
+				return false;
+			}
+			const XMLSessionFrame& frame = session.getFrames()[next];
+			ImGuiIO& io = ImGui::GetIO();
+			io.DeltaTime = frame.deltaTime;
+			io.DisplaySize = frame.displaySize;
+			events.clear();
+			for(const ImGuiInputEvent& input : frame.inputs) {
+				switch(input.Type) {
+					case ImGuiInputEventType_MousePos:
+						io.AddMouseSourceEvent(input.MousePos.MouseSource);
+						io.AddMousePosEvent(input.MousePos.PosX, input.MousePos.PosY);
+						break;
+					case ImGuiInputEventType_MouseWheel:
+						io.AddMouseSourceEvent(input.MouseWheel.MouseSource);
+						io.AddMouseWheelEvent(input.MouseWheel.WheelX, input.MouseWheel.WheelY);
+						break;
+					case ImGuiInputEventType_MouseButton:
+						io.AddMouseSourceEvent(input.MouseButton.MouseSource);
+						io.AddMouseButtonEvent(input.MouseButton.Button, input.MouseButton.Down);
+						break;
+					case ImGuiInputEventType_MouseViewport:
+						io.AddMouseViewportEvent(input.MouseViewport.HoveredViewportID);
+						break;
+					case ImGuiInputEventType_Key:
+						io.AddKeyAnalogEvent(input.Key.Key, input.Key.Down, input.Key.AnalogValue);
+						break;
+					case ImGuiInputEventType_Text:
+						io.AddInputCharacter(input.Text.Char);
+						break;
+					case ImGuiInputEventType_Focus:
+						io.AddFocusEvent(input.AppFocused.Focused);
+						break;
+					default:
+						break;
+				}
+			}
+			return true;
+		}
+
+		void endFrame() {
+			if(events != session.getFrames()[next].events) {
+				mismatches++;
+			}
+			next++;
+		}
+
+		XMLEventCallback observer() {
+			return [this](XMLNode& node) {
+				events.push_back(node.index);
+			};
+		}
+
+		unsigned int getMismatches() const {
+			return mismatches;
+		}
+	};
+
+	XMLReplayer::XMLReplayer(XMLSession& session) : session(session)
+	{
+	}
+
+	XMLReplayer::~XMLReplayer()
+	{
+	}
+
+}
+
+#endif /* DEARIMXML_XMLSESSION_H */
@@ -0,0 +1,339 @@
+#ifndef DEARIMXML_XMLSTRINGPOOL_H
+#define DEARIMXML_XMLSTRINGPOOL_H
+
+#include <XMLIndex.h>
+#include <algorithm>
+#include <atomic>
+#include <cstdint>
+#include <cstring>
+#include <memory>
+#include <mutex>
+#include <new>
+#include <stdexcept>
+#include <string>
+#include <string_view>
+#include <vector>
+
+#if defined(_MSC_VER)
+#include <intrin.h>
+#endif
+
+namespace ImXML {
+
+	//View of a NUL terminated string owned by an XMLStringPool, c_str() can be passed to ImGui directly
+	struct XMLString
+	{
+		const char* data = "";
+		uint32_t length = 0;
+
+		const char* c_str() const {
+			return data;
+		}
+
+		std::size_t size() const {
+			return length;
+		}
+
+		bool empty() const {
+			return length == 0;
+		}
+
+		std::string str() const {
+			return std::string(data, length);
+		}
+
+		operator std::string_view() const {
+			return std::string_view(data, length);
+		}
+
+		friend bool operator==(XMLString a, XMLString b) {
+			return a.data == b.data || std::string_view(a) == std::string_view(b);
+		}
+		friend bool operator!=(XMLString a, XMLString b) {
+			return !(a == b);
+		}
+		friend bool operator==(XMLString a, std::string_view b) {
+			return std::string_view(a) == b;
+		}
+		friend bool operator!=(XMLString a, std::string_view b) {
+			return std::string_view(a) != b;
+		}
+	};
+
+	//Deduplicated storage for the strings of one or more trees, NUL terminated so attributes can refer to
+	//them by 32 bit offset. The offsets are split over chunks that double in size as the pool grows, from
+	//a few KB for small trees up to 4 GiB in total. Chunks never move, so views stay valid while any tree
+	//using the pool is alive. Each string is preceded by its length. Safe to share between loader threads,
+	//strings are spread over shards by hash so concurrent interning rarely waits on the same lock.
+	class XMLStringPool
+	{
+	private:
+		static constexpr std::size_t shardCount = 16;
+		//Chunk 0 holds offsets below firstChunk, chunk k above it holds [firstChunk << (k - 1), firstChunk << k)
+		static constexpr unsigned int firstChunkBits = 12;
+		static constexpr std::size_t firstChunk = std::size_t(1) << firstChunkBits;
+		static constexpr unsigned int chunkCount = 32 - firstChunkBits + 1;
+		static constexpr std::size_t capacity = std::size_t(1) << 32;
+		//Offset of the empty string, placed first so unused table entries can use offset 0
+		static constexpr uint32_t emptyOffset = sizeof(uint32_t);
+
+		std::atomic<char*> chunks[chunkCount] = {};
+		std::mutex chunkMutex;
+		std::atomic<std::size_t> used{0};
+
+		static unsigned int chunkOf(std::size_t offset) {
+			std::size_t above = offset >> firstChunkBits;
+			if(above == 0) {
+				return 0;
+			}
+#if defined(_MSC_VER)
+			unsigned long bit;
+			_BitScanReverse64(&bit, above);
+			return bit + 1;
+#else
+			return 64 - __builtin_clzll(above);
+#endif
+		}
+
+		static std::size_t chunkBegin(unsigned int chunk) {
+			return (firstChunk << chunk) >> 1 & ~(firstChunk >> 1);
+		}
+
+		static std::size_t chunkEnd(unsigned int chunk) {
+			return firstChunk << chunk;
+		}
+
+		char* pointer(uint32_t offset) const {
+			unsigned int chunk = chunkOf(offset);
+			return chunks[chunk].load(std::memory_order_acquire) + (offset - chunkBegin(chunk));
+		}
+
+		//Room for a string of length bytes, its length prefix and NUL, aligned for the next prefix.
+		//A string never spans two chunks, the rest of a chunk it does not fit in stays unused.
+		uint32_t allocate(std::size_t length) {
+			std::size_t size = (sizeof(uint32_t) + length + 1 + 3) & ~std::size_t(3);
+			std::size_t start = used.load(std::memory_order_relaxed);
+			std::size_t begin;
+			do {
+				begin = start;
+				while(begin < capacity && begin + size > chunkEnd(chunkOf(begin))) {
+					begin = chunkEnd(chunkOf(begin));
+				}
+				if(begin + size > capacity) {
+					throw std::runtime_error("String pool is full");
+				}
+			} while(!used.compare_exchange_weak(start, begin + size, std::memory_order_relaxed));
+			unsigned int chunk = chunkOf(begin);
+			if(chunks[chunk].load(std::memory_order_acquire) == nullptr) {
+				std::lock_guard<std::mutex> lock(chunkMutex);
+				if(chunks[chunk].load(std::memory_order_relaxed) == nullptr) {
+					chunks[chunk].store(new char[chunkEnd(chunk) - chunkBegin(chunk)], std::memory_order_release);
+				}
+			}
+			uint32_t length32 = (uint32_t)length;
+			std::memcpy(pointer(begin), &length32, sizeof(length32));
+			return (uint32_t)(begin + sizeof(uint32_t));
+		}
+
+		struct Shard
+		{
+			std::mutex mutex;
+			std::size_t storedBytes = 0;
+			//Open addressing table of the stored strings, hashes are kept to skip most comparisons
+			struct Entry
+			{
+				uint32_t offset;	//0 for unused entries
+				uint32_t length;
+				uint32_t hash;
+			};
+			std::vector<Entry> table;
+			std::size_t count = 0;
+
+			XMLString find(XMLStringPool& pool, std::string_view str, uint32_t hash) {
+				if((count + 1) * 2 > table.size()) {
+					grow();
+				}
+				std::size_t mask = table.size() - 1;
+				//Shards are picked with the low bits, probe with the high ones
+				std::size_t i = (hash >> 4) & mask;
+				for(;; i = (i + 1) & mask) {
+					Entry& entry = table[i];
+					if(entry.offset == 0) {
+						break;
+					}
+					if(entry.hash == hash && std::string_view(pool.pointer(entry.offset), entry.length) == str) {
+						return XMLString{pool.pointer(entry.offset), entry.length};
+					}
+				}
+				uint32_t offset = pool.allocate(str.size());
+				char* data = pool.pointer(offset);
+				std::memcpy(data, str.data(), str.size());
+				data[str.size()] = '\0';
+				storedBytes += str.size() + 1;
+				table[i] = {offset, (uint32_t)str.size(), hash};
+				count++;
+				return XMLString{data, (uint32_t)str.size()};
+			}
+
+			void grow() {
+				std::vector<Entry> old;
+				old.swap(table);
+				table.assign(std::max<std::size_t>(16, old.size() * 2), Entry{0, 0, 0});
+				std::size_t mask = table.size() - 1;
+				for(const Entry& entry : old) {
+					if(entry.offset != 0) {
+						std::size_t i = (entry.hash >> 4) & mask;
+						while(table[i].offset != 0) {
+							i = (i + 1) & mask;
+						}
+						table[i] = entry;
+					}
+				}
+			}
+		};
+
+		Shard shards[shardCount];
+		std::atomic<std::size_t> requested{0};
+	public:
+		XMLStringPool();
+		~XMLStringPool();
+
+		XMLStringPool(const XMLStringPool&) = delete;
+		XMLStringPool& operator=(const XMLStringPool&) = delete;
+
+		XMLString intern(std::string_view str) {
+			return intern(str, hashString(str));
+		}
+
+		//hash must be hashString(str)
+		XMLString intern(std::string_view str, uint32_t hash) {
+			if(str.empty()) {
+				return XMLString();
+			}
+			requested.fetch_add(str.size() + 1, std::memory_order_relaxed);
+			Shard& shard = shards[hash % shardCount];
+			std::lock_guard<std::mutex> lock(shard.mutex);
+			return shard.find(*this, str, hash);
+		}
+
+		//Offset of a string interned in this pool, or of any empty string
+		uint32_t offsetOf(XMLString str) const {
+			if(str.empty()) {
+				return emptyOffset;
+			}
+			for(unsigned int chunk = 0; chunk < chunkCount; chunk++) {
+				const char* data = chunks[chunk].load(std::memory_order_acquire);
+				if(data != nullptr && str.data >= data && str.data < data + (chunkEnd(chunk) - chunkBegin(chunk))) {
+					return (uint32_t)(chunkBegin(chunk) + (str.data - data));
+				}
+			}
+			throw std::runtime_error("String does not belong to this pool");
+		}
+
+		//String at an offset returned by offsetOf
+		XMLString at(uint32_t offset) const {
+			const char* data = pointer(offset);
+			uint32_t length;
+			std::memcpy(&length, data - sizeof(uint32_t), sizeof(length));
+			return XMLString{data, length};
+		}
+
+		//Number of distinct strings
+		std::size_t getCount() {
+			std::size_t count = 0;
+			for(Shard& shard : shards) {
+				std::lock_guard<std::mutex> lock(shard.mutex);
+				count += shard.count;
+			}
+			return count;
+		}
+
+		//Bytes held by the pool, its chunks and the lookup tables
+		std::size_t getBytes() {
+			std::size_t bytes = 0;
+			for(unsigned int chunk = 0; chunk < chunkCount; chunk++) {
+				if(chunks[chunk].load(std::memory_order_acquire) != nullptr) {
+					bytes += chunkEnd(chunk) - chunkBegin(chunk);
+				}
+			}
+			for(Shard& shard : shards) {
+				std::lock_guard<std::mutex> lock(shard.mutex);
+				bytes += shard.table.capacity() * sizeof(Shard::Entry);
+			}
+			return bytes;
+		}
+
+		//Counts a string interned through an XMLStringCache hit
+		void addRequested(std::size_t bytes) {
+			requested.fetch_add(bytes, std::memory_order_relaxed);
+		}
+
+		//Bytes the interned strings would take without deduplication
+		std::size_t getRequestedBytes() const {
+			return requested;
+		}
+
+		//Bytes of the distinct strings, without length prefixes, padding and lookup tables
+		std::size_t getStoredBytes() {
+			std::size_t bytes = 0;
+			for(Shard& shard : shards) {
+				std::lock_guard<std::mutex> lock(shard.mutex);
+				bytes += shard.storedBytes;
+			}
+			return bytes;
+		}
+	};
+
+	XMLStringPool::XMLStringPool()
+	{
+		//The empty string, the only string at a fixed offset
+		allocate(0);
+		pointer(emptyOffset)[0] = '\0';
+	}
+
+	XMLStringPool::~XMLStringPool()
+	{
+		for(auto& chunk : chunks) {
+			delete[] chunk.load();
+		}
+	}
+
+	//Direct mapped cache in front of a pool, used by one thread at a time. Names and values that
+	//repeat across a document are found without taking the pool locks.
+	class XMLStringCache
+	{
+	private:
+		static constexpr std::size_t slotCount = 1024;
+		XMLStringPool& pool;
+		std::vector<XMLString> slots;
+	public:
+		XMLStringCache(XMLStringPool& pool);
+		~XMLStringCache();
+
+		XMLString intern(std::string_view str) {
+			uint32_t hash = hashString(str);
+			XMLString& slot = slots[hash & (slotCount - 1)];
+			if(slot != str || str.empty()) {
+				slot = pool.intern(str, hash);
+			} else {
+				pool.addRequested(str.size() + 1);
+			}
+			return slot;
+		}
+
+		XMLStringPool& getPool() {
+			return pool;
+		}
+	};
+
+	XMLStringCache::XMLStringCache(XMLStringPool& pool) : pool(pool), slots(slotCount)
+	{
+	}
+
+	XMLStringCache::~XMLStringCache()
+	{
+	}
+
+}
+
+#endif /* DEARIMXML_XMLSTRINGPOOL_H */
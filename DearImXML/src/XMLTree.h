@@ -2,42 +2,1027 @@
 #define DEARIMXML_XMLTREE_H
 
 #include <ImGuiEnum.h>
+#include <XMLDynamicBind.h>
+#include <XMLIndex.h>
+#include <XMLStringPool.h>
+#include <algorithm>
+#include <cstdint>
+#include <functional>
+#include <memory>
+#include <stdexcept>
 #include <unordered_map>
 #include <string>
+#include <string_view>
 #include <vector>
 
 namespace ImXML {
 
+	//Set by tree mutations so caches only rebuild the affected subtrees
+	enum XMLDirtyFlags {
+		XMLDirty_None = 0,
+		XMLDirty_Node = 1 << 0,			//attributes changed or node was inserted
+		XMLDirty_Structure = 1 << 1,	//children were inserted, removed or reordered
+		XMLDirty_Children = 1 << 2,		//a descendant has dirty flags
+	};
+
+	struct XMLAttribute
+	{
+		XMLString first;	//name
+		XMLString second;	//value
+	};
+
+	//Attribute items of every node of a tree in one array, each node owns a range of it. A range that
+	//outgrows its place moves to the end of the array, XMLTree packs the array again once most of it
+	//is unused. Items are offsets of the name and value in the pool.
+	class XMLAttributeStore
+	{
+	private:
+		struct Item
+		{
+			uint32_t name;
+			uint32_t value;
+		};
+
+		XMLStringPool* pool;
+		std::vector<Item> items;
+		//Items in ranges that were moved or released
+		std::size_t unused = 0;
+
+		friend class XMLAttributes;
+		friend class XMLTree;
+	public:
+		XMLAttributeStore(XMLStringPool* pool);
+		~XMLAttributeStore();
+
+		XMLAttributeStore(const XMLAttributeStore&) = delete;
+		XMLAttributeStore& operator=(const XMLAttributeStore&) = delete;
+
+		XMLStringPool& getPool() const {
+			return *pool;
+		}
+
+		std::size_t capacity() const {
+			return items.capacity();
+		}
+	};
+
+	XMLAttributeStore::XMLAttributeStore(XMLStringPool* pool) : pool(pool)
+	{
+	}
+
+	XMLAttributeStore::~XMLAttributeStore()
+	{
+	}
+
+	//Attributes of a node as a range of the tree XMLAttributeStore. Nodes have a handful of attributes,
+	//so a linear search beats hashing, and a tree of any size costs a few allocations for all of them.
+	//Iterating and find resolve the items to XMLAttribute views.
+	class XMLAttributes
+	{
+	private:
+		using Item = XMLAttributeStore::Item;
+
+		XMLAttributeStore* store;
+		uint32_t first = 0;
+		uint16_t count = 0;
+		//Items of the store owned by the range, count of them are used
+		uint16_t reserved = 0;
+
+		const Item* data() const {
+			return store != nullptr ? store->items.data() + first : nullptr;
+		}
+
+		Item* data() {
+			return store != nullptr ? store->items.data() + first : nullptr;
+		}
+
+		const Item* findItem(std::string_view name) const {
+			const Item* item = data();
+			for(const Item* last = item + count; item != last; item++) {
+				if(store->pool->at(item->name) == name) {
+					return item;
+				}
+			}
+			return item;
+		}
+
+		void push(Item item) {
+			std::vector<Item>& items = store->items;
+			if(count < reserved) {
+				items[first + count++] = item;
+				return;
+			}
+			if(count == UINT16_MAX) {
+				throw std::runtime_error("Too many attributes");
+			}
+			if(first + reserved != items.size()) {
+				//Only the range at the end can grow in place
+				std::size_t moved = items.size();
+				items.resize(moved + count);
+				std::copy(items.begin() + first, items.begin() + first + count, items.begin() + moved);
+				store->unused += reserved;
+				first = moved;
+				reserved = count;
+			}
+			items.push_back(item);
+			count++;
+			reserved++;
+		}
+
+		//Gives the range back to the store
+		void release() {
+			if(store != nullptr) {
+				if(first + reserved == store->items.size()) {
+					store->items.resize(first);
+				} else {
+					store->unused += reserved;
+				}
+			}
+			first = 0;
+			count = 0;
+			reserved = 0;
+		}
+
+		//Appends the items to packed and takes them from there from now on
+		void pack(std::vector<Item>& packed) {
+			const Item* item = data();
+			std::size_t moved = packed.size();
+			packed.insert(packed.end(), item, item + count);
+			first = moved;
+			reserved = count;
+		}
+
+		friend class XMLTree;
+	public:
+		//Bytes of one attribute in a node
+		static constexpr std::size_t itemSize = sizeof(Item);
+
+		//References returned by the iterator stay valid until it is advanced, the iterator itself until
+		//an attribute of the tree is set
+		class Iterator
+		{
+		private:
+			const XMLStringPool* pool;
+			const Item* item;
+			mutable XMLAttribute current;
+		public:
+			Iterator(const XMLStringPool* pool, const Item* item) : pool(pool), item(item) {
+			}
+
+			const XMLAttribute& operator*() const {
+				current = {pool->at(item->name), pool->at(item->value)};
+				return current;
+			}
+
+			const XMLAttribute* operator->() const {
+				return &**this;
+			}
+
+			Iterator& operator++() {
+				item++;
+				return *this;
+			}
+
+			bool operator==(const Iterator& other) const {
+				return item == other.item;
+			}
+			bool operator!=(const Iterator& other) const {
+				return item != other.item;
+			}
+		};
+
+		XMLAttributes(XMLAttributeStore* store = nullptr);
+		~XMLAttributes();
+
+		//Ranges move with their node, a copy would share the range
+		XMLAttributes(const XMLAttributes&) = delete;
+		XMLAttributes& operator=(const XMLAttributes&) = delete;
+
+		XMLAttributes(XMLAttributes&& other) : store(other.store), first(other.first), count(other.count), reserved(other.reserved) {
+			other.first = 0;
+			other.count = 0;
+			other.reserved = 0;
+		}
+
+		//Attributes bound to another store take a copy of the items into theirs
+		XMLAttributes& operator=(XMLAttributes&& other) {
+			if(store != nullptr && other.store != store) {
+				release();
+				append(other);
+			} else if(this != &other) {
+				release();
+				store = other.store;
+				first = other.first;
+				count = other.count;
+				reserved = other.reserved;
+				other.first = 0;
+				other.count = 0;
+				other.reserved = 0;
+			}
+			return *this;
+		}
+
+		Iterator begin() const {
+			return Iterator(store != nullptr ? store->pool : nullptr, data());
+		}
+
+		Iterator end() const {
+			return Iterator(store != nullptr ? store->pool : nullptr, data() + count);
+		}
+
+		//end() when the node has no such attribute
+		Iterator find(std::string_view name) const {
+			return Iterator(store != nullptr ? store->pool : nullptr, findItem(name));
+		}
+
+		//Empty string when the node has no such attribute
+		XMLString operator[](std::string_view name) const {
+			const Item* item = findItem(name);
+			return item != data() + count ? store->pool->at(item->value) : XMLString();
+		}
+
+		std::size_t size() const {
+			return count;
+		}
+
+		//Adds the attribute or replaces its value
+		void set(std::string_view name, std::string_view value) {
+			XMLStringPool* pool = store->pool;
+			uint32_t interned = pool->offsetOf(pool->intern(value));
+			Item* item = data();
+			for(Item* last = item + count; item != last; item++) {
+				if(pool->at(item->name) == name) {
+					item->value = interned;
+					return;
+				}
+			}
+			push({pool->offsetOf(pool->intern(name)), interned});
+		}
+
+		//Keeps the first value when an attribute is repeated
+		void emplace(std::string_view name, std::string_view value) {
+			if(find(name) == end()) {
+				push({store->pool->offsetOf(store->pool->intern(name)), store->pool->offsetOf(store->pool->intern(value))});
+			}
+		}
+
+		//Same for strings already interned in the pool of these attributes
+		void emplace(XMLString name, XMLString value) {
+			if(find(name) == end()) {
+				push({store->pool->offsetOf(name), store->pool->offsetOf(value)});
+			}
+		}
+
+		//Appends the attributes of other, whose strings are in the same pool
+		void append(const XMLAttributes& other) {
+			for(uint16_t k = 0; k < other.count; k++) {
+				push(other.store->items[other.first + k]);
+			}
+		}
+
+		void erase(std::string_view name) {
+			Item* item = data();
+			for(Item* last = item + count; item != last; item++) {
+				if(store->pool->at(item->name) == name) {
+					std::copy(item + 1, last, item);
+					count--;
+					return;
+				}
+			}
+		}
+	};
+
+	XMLAttributes::XMLAttributes(XMLAttributeStore* store) : store(store)
+	{
+	}
+
+	XMLAttributes::~XMLAttributes()
+	{
+	}
+
+	//Application object attached to a node, a get with another type than the attached one returns nullptr
+	struct XMLUserData
+	{
+		void* ptr = nullptr;
+		const void* type = nullptr;
+
+		//One address per type, shared by every translation unit
+		template<typename T>
+		static const void* typeOf() {
+			static const char tag = 0;
+			return &tag;
+		}
+
+		template<typename T>
+		static XMLUserData make(T* value) {
+			return {value, typeOf<T>()};
+		}
+
+		template<typename T>
+		T* get() const {
+			return type == typeOf<T>() ? static_cast<T*>(ptr) : nullptr;
+		}
+	};
+
 	struct XMLNode
 	{
 		ImGuiEnum type;
-		std::unordered_map<std::string, std::string> args;
+		XMLAttributes args;
 		int flags = 0;
+		//Index in the tree bind table, resolved when the tree is linked (-1 when not bound)
+		int bindSlot = -1;
+		//Slot of the node in the tree pool, dense and stable for the lifetime of the node
+		int index = -1;
+		//Bumped when the slot is freed so handles to the old node become invalid
+		uint32_t generation = 0;
+		int dirty = XMLDirty_Node;
+		//Position in the tree list of nodes with this type, -1 when not indexed
+		int tagPosition = -1;
+		//Set when the tree is linked, see BasicXMLRenderer::attach
+		XMLUserData user;
+		//Byte range of children not parsed yet in the tree lazy source, empty once they are materialized
+		uint32_t lazyBegin = 0;
+		uint32_t lazyEnd = 0;
+		XMLNode* parent = nullptr;
 		std::vector<XMLNode*> children;
+
+		template<typename T>
+		T* getUserData() const {
+			return user.get<T>();
+		}
+	};
+
+	//Nodes of a tree in chunks doubling in size, so a tree of any size costs a few allocations and its
+	//nodes keep their addresses as it grows. Chunk 0 holds slots below firstChunk, chunk k above it
+	//holds [firstChunk << (k - 1), firstChunk << k).
+	class XMLNodePool
+	{
+	private:
+		static constexpr unsigned int firstChunkBits = 4;
+		static constexpr std::size_t firstChunk = std::size_t(1) << firstChunkBits;
+
+		std::vector<std::unique_ptr<XMLNode[]>> chunks;
+		std::size_t count = 0;
+
+		static unsigned int chunkOf(std::size_t index) {
+			std::size_t above = index >> firstChunkBits;
+			if(above == 0) {
+				return 0;
+			}
+#if defined(_MSC_VER)
+			unsigned long bit;
+			_BitScanReverse64(&bit, above);
+			return bit + 1;
+#else
+			return 64 - __builtin_clzll(above);
+#endif
+		}
+
+		static std::size_t chunkBegin(unsigned int chunk) {
+			return (firstChunk << chunk) >> 1 & ~(firstChunk >> 1);
+		}
+	public:
+		XMLNodePool();
+		~XMLNodePool();
+
+		XMLNodePool(XMLNodePool&&) = default;
+		XMLNodePool& operator=(XMLNodePool&&) = default;
+
+		XMLNode& operator[](std::size_t index) {
+			unsigned int chunk = chunkOf(index);
+			return chunks[chunk][index - chunkBegin(chunk)];
+		}
+
+		const XMLNode& operator[](std::size_t index) const {
+			unsigned int chunk = chunkOf(index);
+			return chunks[chunk][index - chunkBegin(chunk)];
+		}
+
+		std::size_t size() const {
+			return count;
+		}
+
+		//Slots allocated, including the ones not used yet
+		std::size_t capacity() const {
+			return chunks.empty() ? 0 : firstChunk << (chunks.size() - 1);
+		}
+
+		XMLNode& emplace_back() {
+			if(count == capacity()) {
+				unsigned int chunk = chunks.size();
+				chunks.push_back(std::make_unique<XMLNode[]>((firstChunk << chunk) - chunkBegin(chunk)));
+			}
+			return (*this)[count++];
+		}
+	};
+
+	XMLNodePool::XMLNodePool()
+	{
+	}
+
+	XMLNodePool::~XMLNodePool()
+	{
+	}
+
+	//Reference to a node that detects when the node was removed, even if its slot was reused
+	struct XMLNodeHandle
+	{
+		uint32_t slot = UINT32_MAX;
+		uint32_t generation = 0;
+	};
+
+	using XMLEventCallback = std::function<void(XMLNode& node)>;
+
+	class XMLTree;
+
+	//What the renderer draws for a <placeholder>, see BasicXMLRenderer::mount
+	struct XMLMount
+	{
+		XMLEventCallback draw;
+		XMLTree* tree = nullptr;
+	};
+
+	//Document kept by a lazy read, deferred children are parsed from it by parse on first use
+	struct XMLLazySource
+	{
+		std::string xml;
+		//Set by the reader that deferred the ranges, parses them with its settings
+		std::function<void(XMLTree& tree, XMLNode& node, std::string_view xml, std::size_t begin, std::size_t end)> parse;
 	};
-	
+
+	class XMLSelector;
+
 
 	class XMLTree
 	{
 	private:
-		XMLNode root;
+		XMLNodePool nodes;
+		std::vector<uint32_t> freeSlots;
+		//Attribute strings, shared with other trees when they were loaded together
+		std::shared_ptr<XMLStringPool> strings;
+		//Attributes of every node, the store keeps its address when the tree is moved
+		std::unique_ptr<XMLAttributeStore> attributes;
+		XMLNode* root = nullptr;
+		std::vector<XMLDynamicBind*> binds;
+		std::vector<XMLEventCallback*> routes;
+		std::vector<XMLMount*> mounts;
+		std::vector<XMLNode*> templates;
+		unsigned int linkGeneration = 0;
+		//Changes whenever bind slots are added, removed or pointed at other binds
+		unsigned int slotGeneration = 0;
+		XMLIdIndex ids;
+		std::vector<XMLNode*> tags[IMGUIENUM_COUNT];
+		std::shared_ptr<XMLLazySource> lazySource;
+
+		//Structural mutations requested while the tree is rendered, applied on unlock
+		struct PendingMutation
+		{
+			XMLNodeHandle node;
+			XMLNodeHandle parent;
+			std::size_t position;
+			bool remove;
+		};
+		bool locked = false;
+		std::vector<PendingMutation> pending;
+
+		void markDirty(XMLNode& node, int flags) {
+			node.dirty |= flags;
+			for(XMLNode* parent = node.parent; parent != nullptr && !(parent->dirty & XMLDirty_Children); parent = parent->parent) {
+				parent->dirty |= XMLDirty_Children;
+			}
+		}
+
+		void detach(XMLNode& node) {
+			if(node.parent != nullptr) {
+				auto& siblings = node.parent->children;
+				siblings.erase(std::find(siblings.begin(), siblings.end(), &node));
+				markDirty(*node.parent, XMLDirty_Structure);
+				node.parent = nullptr;
+			}
+		}
+
+		static bool contains(const XMLNode& node, const XMLNode* descendant) {
+			for(; descendant != nullptr; descendant = descendant->parent) {
+				if(descendant == &node) {
+					return true;
+				}
+			}
+			return false;
+		}
+
+		void attach(XMLNode& node, XMLNode& parent, std::size_t position) {
+			auto& siblings = parent.children;
+			siblings.insert(siblings.begin() + std::min(position, siblings.size()), &node);
+			node.parent = &parent;
+			markDirty(parent, XMLDirty_Structure);
+		}
+
+		void addToIndex(XMLNode& node) {
+			auto& nodes = tags[node.type];
+			node.tagPosition = nodes.size();
+			nodes.push_back(&node);
+			auto id = node.args.find("id");
+			if(id != node.args.end()) {
+				ids.insert(id->second, &node);
+			}
+		}
+
+		void removeFromIndex(XMLNode& node) {
+			if(node.tagPosition >= 0) {
+				auto& nodes = tags[node.type];
+				nodes[node.tagPosition] = nodes.back();
+				nodes[node.tagPosition]->tagPosition = node.tagPosition;
+				nodes.pop_back();
+				node.tagPosition = -1;
+			}
+			auto id = node.args.find("id");
+			if(id != node.args.end()) {
+				ids.erase(id->second, &node);
+			}
+		}
+
+		void indexSubtree(XMLNode& node) {
+			addToIndex(node);
+			for(auto child : node.children) {
+				indexSubtree(*child);
+			}
+		}
+
+		void freeNode(XMLNode& node) {
+			for(auto child : node.children) {
+				freeNode(*child);
+			}
+			removeFromIndex(node);
+			if(node.bindSlot >= 0 && node.bindSlot < (int)binds.size()) {
+				binds[node.bindSlot] = nullptr;
+			}
+			if(node.index < (int)routes.size()) {
+				routes[node.index] = nullptr;
+			}
+			if(node.index < (int)mounts.size()) {
+				mounts[node.index] = nullptr;
+			}
+			if(node.index < (int)templates.size()) {
+				templates[node.index] = nullptr;
+			}
+			uint32_t generation = node.generation + 1;
+			int index = node.index;
+			//Gives the attribute range back to the store
+			node = XMLNode();
+			node.generation = generation;
+			node.index = index;
+			freeSlots.push_back(index);
+		}
+
+		void applyInsert(XMLNode& node, XMLNode& parent, std::size_t position) {
+			if(contains(node, &parent)) {
+				throw std::runtime_error("Cannot move a node into its own subtree");
+			}
+			detach(node);
+			attach(node, parent, position);
+		}
+
+		void applyRemove(XMLNode& node) {
+			if(&node == root) {
+				throw std::runtime_error("Cannot remove the root node");
+			}
+			detach(node);
+			freeNode(node);
+			compactAttributes();
+		}
+
+		//Packs the attribute ranges of the nodes once most of the store is unused
+		void compactAttributes() {
+			std::vector<XMLAttributeStore::Item>& items = attributes->items;
+			if(attributes->unused < 1024 || attributes->unused * 2 < items.size()) {
+				return;
+			}
+			std::vector<XMLAttributeStore::Item> packed;
+			packed.reserve(items.size() - attributes->unused);
+			for(std::size_t index = 0; index < nodes.size(); index++) {
+				if(nodes[index].args.store == attributes.get()) {
+					nodes[index].args.pack(packed);
+				}
+			}
+			items.swap(packed);
+			attributes->unused = 0;
+		}
 	public:
-		XMLTree(XMLNode root);
+		XMLTree();
+		XMLTree(std::shared_ptr<XMLStringPool> strings);
 		~XMLTree();
 
+		XMLTree(const XMLTree&) = delete;
+		XMLTree& operator=(const XMLTree&) = delete;
+		XMLTree(XMLTree&&) = default;
+		XMLTree& operator=(XMLTree&&) = default;
+
 		XMLNode& getRoot() {
-			return root;
+			return *root;
+		}
+
+		const XMLNode& getRoot() const {
+			return *root;
+		}
+
+		bool hasRoot() const {
+			return root != nullptr;
+		}
+
+		void setRoot(XMLNode& node) {
+			root = &node;
+		}
+
+		//Allocates a node from the pool and appends it to parent without marking anything dirty,
+		//used while building a tree before it is linked
+		XMLNode& createNode(ImGuiEnum type, XMLNode* parent = nullptr) {
+			XMLNode* node;
+			if(freeSlots.empty()) {
+				node = &nodes.emplace_back();
+				node->index = nodes.size() - 1;
+			} else {
+				node = &nodes[freeSlots.back()];
+				freeSlots.pop_back();
+			}
+			node->type = type;
+			node->args = XMLAttributes(attributes.get());
+			if(parent != nullptr) {
+				parent->children.push_back(node);
+				node->parent = parent;
+			}
+			return *node;
+		}
+
+		//Indexes a node made with createNode once its attributes are set and marks it for linking,
+		//for nodes added to a tree that may already be rendered. Not while the tree is locked.
+		void publish(XMLNode& node) {
+			addToIndex(node);
+			node.dirty = XMLDirty_Node;
+			if(node.parent != nullptr) {
+				markDirty(*node.parent, XMLDirty_Structure);
+			}
+		}
+
+		//Rebuilds the id and tag indexes from the root, done once after a tree is built.
+		//Mutations through the tree API keep them up to date afterwards.
+		void reindex() {
+			ids.clear();
+			for(auto& nodes : tags) {
+				for(auto node : nodes) {
+					node->tagPosition = -1;
+				}
+				nodes.clear();
+			}
+			if(root != nullptr) {
+				indexSubtree(*root);
+			}
+		}
+
+		//Node with this id attribute, nullptr if there is none. When several nodes share the id it is the
+		//one that got it last.
+		XMLNode* find(std::string_view id) const {
+			return ids.find(id);
+		}
+
+		//Appends every node with this id attribute
+		void findAll(std::string_view id, std::vector<XMLNode*>& out) const {
+			ids.findAll(id, out);
+		}
+
+		//<template> element with this name, nullptr if there is none
+		XMLNode* findTemplate(std::string_view name) const {
+			for(auto node : tags[ImGuiEnum::TEMPLATE]) {
+				if(node->args["name"] == name) {
+					return node;
+				}
+			}
+			return nullptr;
+		}
+
+		//Every node of a tag, in no particular order
+		const std::vector<XMLNode*>& findAll(ImGuiEnum type) const {
+			return tags[type];
+		}
+
+		//Nodes matching a selector such as "begin[name='Inspector'] sliderfloat", in no particular order.
+		//Compile selectors used every frame once with XMLSelector, see XMLQuery.h.
+		std::vector<XMLNode*> query(const XMLSelector& selector);
+		std::vector<XMLNode*> query(std::string_view selector);
+
+		XMLNodeHandle handle(const XMLNode& node) const {
+			return {(uint32_t)node.index, node.generation};
+		}
+
+		//Returns nullptr when the node was removed
+		XMLNode* get(XMLNodeHandle handle) {
+			if(handle.slot >= nodes.size() || nodes[handle.slot].generation != handle.generation) {
+				return nullptr;
+			}
+			return &nodes[handle.slot];
+		}
+
+		//Creates a node under parent, at the end when position is past the last child
+		XMLNodeHandle insert(XMLNodeHandle parent, ImGuiEnum type, std::size_t position = SIZE_MAX) {
+			XMLNode* parentNode = get(parent);
+			if(parentNode == nullptr) {
+				throw std::runtime_error("Invalid parent node handle");
+			}
+			XMLNode& node = createNode(type);
+			node.dirty = XMLDirty_Node;
+			addToIndex(node);
+			XMLNodeHandle inserted = handle(node);
+			if(locked) {
+				pending.push_back({inserted, parent, position, false});
+			} else {
+				applyInsert(node, *parentNode, position);
+			}
+			return inserted;
+		}
+
+		//Removes the node and its subtree, their handles become invalid
+		void remove(XMLNodeHandle node) {
+			XMLNode* removed = get(node);
+			if(removed == nullptr) {
+				throw std::runtime_error("Invalid node handle");
+			}
+			if(removed == root) {
+				throw std::runtime_error("Cannot remove the root node");
+			}
+			if(locked) {
+				pending.push_back({node, {}, 0, true});
+			} else {
+				applyRemove(*removed);
+			}
+		}
+
+		void move(XMLNodeHandle node, XMLNodeHandle parent, std::size_t position = SIZE_MAX) {
+			XMLNode* moved = get(node);
+			XMLNode* parentNode = get(parent);
+			if(moved == nullptr || parentNode == nullptr) {
+				throw std::runtime_error("Invalid node handle");
+			}
+			if(locked) {
+				pending.push_back({node, parent, position, false});
+			} else {
+				applyInsert(*moved, *parentNode, position);
+			}
+		}
+
+		void setAttribute(XMLNodeHandle node, std::string_view key, std::string_view value) {
+			XMLNode* changed = get(node);
+			if(changed == nullptr) {
+				throw std::runtime_error("Invalid node handle");
+			}
+			if(key == "id") {
+				removeFromIndex(*changed);
+				changed->args.set(key, value);
+				addToIndex(*changed);
+			} else {
+				changed->args.set(key, value);
+			}
+			compactAttributes();
+			markDirty(*changed, XMLDirty_Node);
+		}
+
+		void removeAttribute(XMLNodeHandle node, std::string_view key) {
+			XMLNode* changed = get(node);
+			if(changed == nullptr) {
+				throw std::runtime_error("Invalid node handle");
+			}
+			if(key == "id") {
+				removeFromIndex(*changed);
+				changed->args.erase(key);
+				addToIndex(*changed);
+			} else {
+				changed->args.erase(key);
+			}
+			markDirty(*changed, XMLDirty_Node);
+		}
+
+		void setFlags(XMLNodeHandle node, int flags) {
+			XMLNode* changed = get(node);
+			if(changed == nullptr) {
+				throw std::runtime_error("Invalid node handle");
+			}
+			changed->flags = flags;
+			markDirty(*changed, XMLDirty_Node);
+		}
+
+		void setLazySource(std::shared_ptr<XMLLazySource> source) {
+			lazySource = std::move(source);
+		}
+
+		static bool isLazy(const XMLNode& node) {
+			return node.lazyEnd > node.lazyBegin;
+		}
+
+		//Parses and attaches the children a lazy read deferred, returns false when there were none.
+		//Safe while the tree is locked, the node gets no children until this is called.
+		bool materialize(XMLNode& node) {
+			if(!isLazy(node) || lazySource == nullptr) {
+				return false;
+			}
+			std::size_t begin = node.lazyBegin;
+			std::size_t end = node.lazyEnd;
+			node.lazyBegin = node.lazyEnd = 0;
+			lazySource->parse(*this, node, lazySource->xml, begin, end);
+			for(auto child : node.children) {
+				indexSubtree(*child);
+			}
+			markDirty(node, XMLDirty_Structure);
+			return true;
+		}
+
+		//Text of the children a lazy read deferred, empty when node has none
+		std::string_view getDeferred(const XMLNode& node) const {
+			if(!isLazy(node) || lazySource == nullptr) {
+				return std::string_view();
+			}
+			return std::string_view(lazySource->xml).substr(node.lazyBegin, node.lazyEnd - node.lazyBegin);
+		}
+
+		//Defers the children of a childless node to the text source defers in from, e.g. when a reload changed a
+		//subtree that was not shown yet. Nothing is parsed until the node is materialized.
+		void defer(XMLNodeHandle handle, const XMLTree& from, const XMLNode& source) {
+			XMLNode* node = get(handle);
+			if(node == nullptr) {
+				throw std::runtime_error("Invalid node handle");
+			}
+			if(!node->children.empty()) {
+				throw std::runtime_error("Only nodes without children can be deferred");
+			}
+			std::string_view text = from.getDeferred(source);
+			if(text.empty()) {
+				node->lazyBegin = node->lazyEnd = 0;
+				return;
+			}
+			if(lazySource == nullptr) {
+				lazySource = std::make_shared<XMLLazySource>();
+				lazySource->parse = from.lazySource->parse;
+			}
+			//Ranges of other nodes stay valid as the text is only appended to, text may point into it
+			std::string copy(text);
+			node->lazyBegin = lazySource->xml.size();
+			lazySource->xml.append(copy);
+			node->lazyEnd = lazySource->xml.size();
+		}
+
+		//Materializes every deferred subtree, e.g. before querying the whole tree
+		void materializeAll() {
+			std::vector<XMLNode*> stack;
+			if(root != nullptr) {
+				stack.push_back(root);
+			}
+			while(!stack.empty()) {
+				XMLNode* node = stack.back();
+				stack.pop_back();
+				materialize(*node);
+				stack.insert(stack.end(), node->children.begin(), node->children.end());
+			}
+		}
+
+		bool isDirty() const {
+			return root != nullptr && root->dirty != XMLDirty_None;
+		}
+
+		//While locked (during rendering) insert, remove and move are queued so traversal stays valid
+		void lock() {
+			locked = true;
+		}
+
+		bool isLocked() const {
+			return locked;
+		}
+
+		//Applies the queued mutations and never throws, it runs from XMLTreeLock's destructor. Mutations
+		//that became invalid while queued, such as a move under a node that was since moved below it, are skipped.
+		void unlock() {
+			locked = false;
+			std::vector<PendingMutation> queued;
+			queued.swap(pending);
+			for(const PendingMutation& mutation : queued) {
+				XMLNode* node = get(mutation.node);
+				if(node == nullptr || node == root) {
+					continue;
+				}
+				XMLNode* parent = get(mutation.parent);
+				if(mutation.remove) {
+					applyRemove(*node);
+				} else if(parent != nullptr) {
+					if(!contains(*node, parent)) {
+						applyInsert(*node, *parent, mutation.position);
+					}
+				} else if(node->parent == nullptr) {
+					//Inserted under a node removed in the same frame
+					freeNode(*node);
+				}
+			}
+		}
+
+		std::shared_ptr<XMLStringPool> getStrings() const {
+			return strings;
+		}
+
+		//Store of the attributes of the nodes, for XMLAttributes built before their node is created
+		XMLAttributeStore& getAttributeStore() const {
+			return *attributes;
+		}
+
+		//Bytes held by the nodes and indexes of the tree, without the shared attribute strings. Visits every
+		//node for its child list, so it costs O(nodes).
+		std::size_t getMemoryUsage() const {
+			std::size_t bytes = sizeof(XMLTree) + nodes.capacity() * sizeof(XMLNode) + freeSlots.capacity() * sizeof(uint32_t);
+			for(std::size_t index = 0; index < nodes.size(); index++) {
+				bytes += nodes[index].children.capacity() * sizeof(XMLNode*);
+			}
+			bytes += sizeof(XMLAttributeStore) + attributes->capacity() * XMLAttributes::itemSize;
+			for(const auto& nodes : tags) {
+				bytes += nodes.capacity() * sizeof(XMLNode*);
+			}
+			if(lazySource != nullptr) {
+				bytes += lazySource->xml.capacity();
+			}
+			return bytes + ids.getMemoryUsage() + binds.capacity() * sizeof(XMLDynamicBind*) + routes.capacity() * sizeof(XMLEventCallback*) + mounts.capacity() * sizeof(XMLMount*) + templates.capacity() * sizeof(XMLNode*);
+		}
+
+		//Number of pool slots, node indices are below this
+		std::size_t getCapacity() const {
+			return nodes.size();
+		}
+
+		std::vector<XMLDynamicBind*>& getBinds() {
+			return binds;
+		}
+
+		//Event callback of each node by index, nullptr when the node has none
+		std::vector<XMLEventCallback*>& getRoutes() {
+			return routes;
+		}
+
+		//Mount of each placeholder by node index, nullptr for other nodes and unmounted placeholders
+		std::vector<XMLMount*>& getMounts() {
+			return mounts;
+		}
+
+		//Template of each <use> node by index, nullptr for other nodes
+		std::vector<XMLNode*>& getTemplates() {
+			return templates;
+		}
+
+		unsigned int getLinkGeneration() const {
+			return linkGeneration;
+		}
+
+		void setLinkGeneration(unsigned int generation) {
+			linkGeneration = generation;
+		}
+
+		unsigned int getSlotGeneration() const {
+			return slotGeneration;
+		}
+
+		void setSlotGeneration(unsigned int generation) {
+			slotGeneration = generation;
 		}
 	};
-	
-	XMLTree::XMLTree(XMLNode root) : root(root)
+
+	XMLTree::XMLTree() : strings(std::make_shared<XMLStringPool>()), attributes(std::make_unique<XMLAttributeStore>(strings.get()))
+	{
+	}
+
+	XMLTree::XMLTree(std::shared_ptr<XMLStringPool> strings) : strings(std::move(strings)), attributes(std::make_unique<XMLAttributeStore>(this->strings.get()))
 	{
 	}
-	
+
 	XMLTree::~XMLTree()
 	{
 	}
-	
+
+	//Locks a tree for the scope of a render, it is unlocked again when a handler or route throws
+	class XMLTreeLock
+	{
+	private:
+		XMLTree& tree;
+	public:
+		XMLTreeLock(XMLTree& tree);
+		~XMLTreeLock();
+
+		XMLTreeLock(const XMLTreeLock&) = delete;
+		XMLTreeLock& operator=(const XMLTreeLock&) = delete;
+	};
+
+	XMLTreeLock::XMLTreeLock(XMLTree& tree) : tree(tree)
+	{
+		tree.lock();
+	}
+
+	XMLTreeLock::~XMLTreeLock()
+	{
+		tree.unlock();
+	}
+
 }
 
+#include <XMLQuery.h>
+
 #endif /* DEARIMXML_XMLTREE_H */
@@ -16,6 +16,11 @@
 #include <XMLRenderer.h>
 #include <XMLEventHandler.h>
 #include <XMLDynamicBind.h>
+#include <XMLSession.h>
+#include <XMLHotReload.h>
+#include <XMLFonts.h>
+#include <XMLEmbed.h>
+#include <memory>
 
 class Handler : public ImXML::XMLEventHandler {
     virtual void onNodeBegin(ImXML::XMLNode& node) override {
@@ -27,9 +32,7 @@ class Handler : public ImXML::XMLEventHandler {
     }
 
     virtual void onEvent(ImXML::XMLNode& node) override {
-        if(node.args["id"] == "btn0") {
-            node.args["label"] = "Clicked";
-        }
+
     }
 
 };
@@ -75,25 +78,62 @@ int main(int argc, char const *argv[])
     ImGui_ImplOpenGL3_Init(glsl_version);
 
 	ImXML::XMLReader reader = ImXML::XMLReader();
-	ImXML::XMLTree tree = reader.read("Assets/test.xml");
+	//Compiled in by imxml_embed_layouts, --hot-reload still watches Assets/test.xml
+	ImXML::XMLTree tree = reader.readBuffer(ImXML::getEmbeddedLayout("test"));
+    //Fonts declared with <font> in the layout. With --font-cache <dir> later launches load the built
+    //atlas from dir instead of rasterizing the fonts again.
+    ImXML::XMLFontLoader fonts;
+    fonts.load(tree, *io.Fonts, "Assets");
+    for(int i = 1; i + 1 < argc; i++) {
+        if(std::string(argv[i]) == "--font-cache") {
+            ImXML::XMLFontCache fontCache(argv[i + 1]);
+            fontCache.build(*io.Fonts);
+        }
+    }
     ImXML::XMLRenderer renderer;
     float float0;
-    char buf[512] = {0};
+    std::string str0;
     float color0[3] = {0};
     float color1[4] = {0};
-    renderer.addDynamicBind(std::string("float0"), {.ptr = &float0});
-    renderer.addDynamicBind(std::string("str0"), {.ptr = buf, .size=512});
-    renderer.addDynamicBind(std::string("color0"), {.ptr = color0});
-    renderer.addDynamicBind(std::string("color1"), {.ptr = color1});
+    renderer.addBind("float0", float0);
+    renderer.addBind("str0", str0);
+    renderer.addBind("color0", color0);
+    renderer.addBind("color1", color1);
+    renderer.on("btn0", [&tree](ImXML::XMLNode& node) {
+        tree.setAttribute(tree.handle(node), "label", "Clicked");
+    });
+    renderer.mount("custom0", [&float0](ImXML::XMLNode& node) {
+        ImGui::ProgressBar(float0);
+    });
     Handler handler;
 
+    //--record <file> saves the input and events of this run for DearImXMLReplayBench
+    ImXML::XMLSession session;
+    ImXML::XMLRecorder recorder(session);
+    bool recording = argc > 2 && std::string(argv[1]) == "--record";
+    if(recording) {
+        renderer.setEventObserver(recorder.observer());
+    }
+
+    //--hot-reload patches the layout whenever Assets/test.xml is saved
+    std::unique_ptr<ImXML::XMLHotReload> reload;
+    if(argc > 1 && std::string(argv[argc-1]) == "--hot-reload") {
+        reload = std::make_unique<ImXML::XMLHotReload>("Assets/test.xml", reader);
+    }
+
 	while (!glfwWindowShouldClose(window))
     {
         IM_ASSERT(ImGui::GetCurrentContext() != NULL && "Missing dear imgui context. Refer to examples app!");
         glfwPollEvents();
+        if(reload) {
+            reload->apply(tree);
+        }
 
         ImGui_ImplOpenGL3_NewFrame();
         ImGui_ImplGlfw_NewFrame();
+        if(recording) {
+            recorder.beginFrame();
+        }
         ImGui::NewFrame();
 
         glClearColor(0.45f, 0.55f, 0.60f, 1.00f);
@@ -104,6 +144,9 @@ int main(int argc, char const *argv[])
 
         // Render dear imgui into screen
         ImGui::Render();
+        if(recording) {
+            recorder.endFrame();
+        }
 
         int display_w, display_h;
         glfwGetFramebufferSize(window, &display_w, &display_h);
@@ -111,6 +154,10 @@ int main(int argc, char const *argv[])
         ImGui_ImplOpenGL3_RenderDrawData(ImGui::GetDrawData());
         glfwSwapBuffers(window);
     }
+
+    if(recording) {
+        session.save(argv[2]);
+    }
     
 	return 0;
 }
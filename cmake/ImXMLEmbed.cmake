@@ -0,0 +1,53 @@
+#Compiles layouts into a target as byte arrays, read at runtime with
+#	reader.readBuffer(ImXML::getEmbeddedLayout("name"))
+#where name is the file name without extension. The arrays are regenerated when a layout changes.
+#	imxml_embed_layouts(MyApp DearImXML/Assets/test.xml DearImXML/Assets/menu.xml)
+#Layouts embedded into an executable register themselves before main. The linker drops the generated
+#object from a static library when nothing references it, there call the registration function once:
+#	IMXML_EMBEDDED_LAYOUTS(MyLib)	//at namespace scope, target name with non identifier characters as _
+#	ImXML::registerEmbeddedLayouts_MyLib();
+
+set(IMXML_EMBED_SCRIPT "${CMAKE_CURRENT_LIST_FILE}")
+
+function(imxml_embed_layouts target)
+	set(output "${CMAKE_CURRENT_BINARY_DIR}/${target}_layouts.cpp")
+	set(layouts "")
+	foreach(file ${ARGN})
+		get_filename_component(path "${file}" ABSOLUTE)
+		list(APPEND layouts "${path}")
+	endforeach()
+	#Lists cannot be passed through -D as they are, | does not appear in paths
+	string(REPLACE ";" "|" joined "${layouts}")
+	string(MAKE_C_IDENTIFIER "${target}" id)
+	add_custom_command(
+		OUTPUT "${output}"
+		COMMAND ${CMAKE_COMMAND} "-DIMXML_EMBED_OUTPUT=${output}" "-DIMXML_EMBED_LAYOUTS=${joined}" "-DIMXML_EMBED_ID=${id}" -P "${IMXML_EMBED_SCRIPT}"
+		DEPENDS ${layouts} "${IMXML_EMBED_SCRIPT}"
+		COMMENT "Embedding layouts into ${target}"
+		VERBATIM
+	)
+	target_sources(${target} PRIVATE "${output}")
+endfunction()
+
+#Script mode, writes the source file for imxml_embed_layouts
+if(CMAKE_SCRIPT_MODE_FILE AND DEFINED IMXML_EMBED_OUTPUT)
+	string(REPLACE "|" ";" layouts "${IMXML_EMBED_LAYOUTS}")
+	set(source "//Generated by imxml_embed_layouts, do not edit\n#include <XMLEmbed.h>\n\nnamespace {\n")
+	set(calls "")
+	set(index 0)
+	foreach(path ${layouts})
+		get_filename_component(name "${path}" NAME_WLE)
+		#Names become C string literals
+		string(REPLACE "\\" "\\\\" name "${name}")
+		string(REPLACE "\"" "\\\"" name "${name}")
+		file(READ "${path}" hex HEX)
+		string(REGEX REPLACE "([0-9a-f][0-9a-f])" "0x\\1," bytes "${hex}")
+		#NUL terminated so the bytes are also a valid C string
+		string(APPEND source "\tconst unsigned char layout${index}[] = {${bytes}0x00};\n")
+		string(APPEND calls "\t\tembeddedLayouts().insert_or_assign(\"${name}\", std::string_view(reinterpret_cast<const char*>(layout${index}), sizeof(layout${index}) - 1));\n")
+		math(EXPR index "${index} + 1")
+	endforeach()
+	string(APPEND source "}\n\nnamespace ImXML {\n\tvoid registerEmbeddedLayouts_${IMXML_EMBED_ID}() {\n${calls}\t}\n}\n\n")
+	string(APPEND source "namespace {\n\tconst ImXML::XMLEmbeddedLayouts registration(ImXML::registerEmbeddedLayouts_${IMXML_EMBED_ID});\n}\n")
+	file(WRITE "${IMXML_EMBED_OUTPUT}" "${source}")
+endif()